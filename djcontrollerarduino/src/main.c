@@ -13,22 +13,28 @@
 #include "commands.h"
 #include "sound.h"
 #include "playlist.h"
+#include "systick.h"
+#include "beat.h"
+#include "arena.h"
+#include "random.h"
+#include "storage.h"
 
-volatile uint16_t beat_counter = 0;
-volatile uint8_t beat_detected = 0;
+#define MAX_TRACKS PLAYLIST_MAX_TRACKS
+
+ARENA_CHECK(PLAYLIST_ARENA_BYTES(MAX_TRACKS));
+
+static const AdcScanChannel control_channels[] = {
+    { POT_PIN, 2, 4 },         // CONTROL_SEEK
+    { VOLUME_POT_PIN, 3, 8 },  // CONTROL_VOLUME
+    { BPM_POT_PIN, 3, 8 },     // CONTROL_BPM
+    // Add CROSSFADE_POT_PIN and EQ_POT_PIN on boards that expose ADC6/ADC7
+};
 
-void timer1_init(void);
 void init_all_peripherals(void);
 void perform_startup_sequence(void);
 
-ISR(TIMER1_COMPA_vect) {
-    beat_counter++;
-    
-    if ((beat_counter % 500) == 0) {
-        if ((beat_counter % 2000) == 0) {
-            beat_detected = 1;
-        }
-    }
+void systick_hook(void) {
+    beat_tick();
 }
 
 int main(void) {
@@ -37,9 +43,16 @@ int main(void) {
     display_init();
     buttons_init();
     potentiometer_init();
+    adc_scan_init(control_channels, sizeof(control_channels) / sizeof(control_channels[0]));
+    potentiometer_set_mode(POT_MODE_SCRUB);
     usart_init();
+    storage_init();
     commands_init();
-    timer1_init();
+    beat_init();
+    systick_init();
+
+    // Everything is set up, the drivers can start their interrupts
+    sei();
     
     leds_test();
     
@@ -52,42 +65,35 @@ int main(void) {
 
     play_startup_sequence();
 
-    uint8_t max_tracks = 20;
-    Playlist* playlist = playlist_create(max_tracks);
+    // Seeds the shuffle order
+    random_global_init();
+
+    commands_restore_state();
+
+    Playlist* playlist = playlist_create(MAX_TRACKS);
     
     commands_set_playlist(&playlist);
     
-    display_string("PAUS");
+    display_string(isPlaying ? "PLAY" : "PAUS");
     
     send_command(CMD_REQUEST_STATUS);
     
-    sei();
-    
     while (1) {
         display_update(1);
         buttons_check();
         potentiometer_check();
+        controls_check();
         process_serial();
 
-        if (beat_detected) {
-            beat_detected = 0;
-            
-            led_on(LED_STATUS_PIN);
-            for (uint8_t i = 0; i < 25; i++) {
-                _delay_ms(1);
-            }
-            led_off(LED_STATUS_PIN);
+        if (beat_poll()) {
+            led_pulse(LED_STATUS_PIN, 150);
         }
         playlist_check_update(playlist);
+
+        commands_save_state();
+        storage_poll();
     }
     playlist_destroy(playlist);
     
     return 0;
 }
-
-void timer1_init(void) {
-    TCCR1B |= (1 << WGM12);
-    TCCR1B |= (1 << CS12) | (1 << CS10);
-    OCR1A = 15;  // 16MHz / 1024 / 16 ≈ 1ms
-    TIMSK1 |= (1 << OCIE1A);
-}
\ No newline at end of file
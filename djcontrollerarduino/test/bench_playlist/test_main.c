@@ -0,0 +1,100 @@
+/**
+ * Host micro-benchmark for the playlist library
+ * Reports operations per second of the hot calls and the arena bytes per
+ * track. Host numbers only compare versions of the code, they are not
+ * AVR timings.
+ *
+ * Run with: pio test -e native -f bench_playlist -v
+ */
+
+#include <unity.h>
+#include <stdio.h>
+#include <time.h>
+#include "playlist.h"
+#include "random.h"
+
+#define BENCH_OPS 20000000L
+
+void display_string(const char* str) {
+    (void)str;
+}
+
+uint32_t systick_millis(void) {
+    return 0;
+}
+
+static Playlist* playlist;
+static volatile uint8_t sink;
+
+void setUp(void) {
+    playlist = playlist_create(PLAYLIST_MAX_TRACKS);
+    TEST_ASSERT_NOT_NULL(playlist);
+
+    for (uint8_t i = 0; i < PLAYLIST_MAX_TRACKS; i++) {
+        playlist_append_track(playlist, PLAYLIST_DEFAULT_DURATION);
+    }
+}
+
+void tearDown(void) {
+    playlist_destroy(playlist);
+}
+
+static void report(const char* name, clock_t start) {
+    double seconds = (double)(clock() - start) / CLOCKS_PER_SEC;
+
+    printf("%-24s %8.1f Mops/s\n", name, BENCH_OPS / seconds / 1e6);
+}
+
+void bench_next(void) {
+    clock_t start = clock();
+
+    for (long i = 0; i < BENCH_OPS; i++) {
+        playlist_next_track(playlist);
+        sink += playlist->current_index;
+    }
+
+    report("next", start);
+}
+
+void bench_shuffle_next(void) {
+    playlist_set_shuffle(playlist, 1);
+
+    clock_t start = clock();
+
+    for (long i = 0; i < BENCH_OPS; i++) {
+        playlist_next_track(playlist);
+        sink += playlist->current_index;
+    }
+
+    report("shuffle next", start);
+}
+
+void bench_jump_and_prev(void) {
+    clock_t start = clock();
+
+    for (long i = 0; i < BENCH_OPS / 2; i++) {
+        playlist_set_current_track(playlist, i % PLAYLIST_MAX_TRACKS);
+        playlist_prev_track(playlist);
+        sink += playlist->current_index;
+    }
+
+    report("jump + history prev", start);
+}
+
+void bench_bytes_per_track(void) {
+    size_t bytes = PLAYLIST_ARENA_BYTES(PLAYLIST_MAX_TRACKS) - ARENA_BYTES(sizeof(Playlist));
+
+    printf("%-24s %8.2f bytes (%u tracks, plus %u for the playlist)\n", "per track",
+           (double)bytes / PLAYLIST_MAX_TRACKS, PLAYLIST_MAX_TRACKS, (unsigned)sizeof(Playlist));
+}
+
+int main(void) {
+    random_global_init();
+
+    UNITY_BEGIN();
+    RUN_TEST(bench_next);
+    RUN_TEST(bench_shuffle_next);
+    RUN_TEST(bench_jump_and_prev);
+    RUN_TEST(bench_bytes_per_track);
+    return UNITY_END();
+}
@@ -0,0 +1,152 @@
+/**
+ * Host benchmark for bounded random integers
+ * Compares the division-based random_int_range() it replaced with
+ * random_int_range(), random_bounded32() and random_bounded64(), and
+ * checks that the results stay uniform. Host numbers only compare the
+ * methods, they are not AVR timings.
+ *
+ * Run with: pio test -e native -f bench_random_bounded -v
+ */
+
+#include <unity.h>
+#include <stdio.h>
+#include <limits.h>
+#include <time.h>
+#include "random.h"
+
+#define BENCH_OPS 50000000L
+
+static random_state_t state;
+static volatile long sink;
+
+void setUp(void) {
+    random_init_with_seed(&state, 7);
+}
+
+void tearDown(void) {}
+
+/**
+ * The previous random_int_range(), two 64-bit divisions per call
+ * Not inlined, so the divisions cannot be hoisted out of the loop
+ */
+__attribute__((noinline)) static int old_int_range(random_state_t* s, int min, int max) {
+    uint64_t range = (uint64_t)(max - min) + 1;
+    uint64_t scale = 0xFFFFFFFFFFFFFFFFULL / range;
+    uint64_t limit = range * scale;
+    uint64_t r;
+
+    do {
+        r = random_uint64(s);
+    } while (r >= limit);
+
+    return min + (int)(r / scale);
+}
+
+static double mops(clock_t start) {
+    return BENCH_OPS / ((double)(clock() - start) / CLOCKS_PER_SEC) / 1e6;
+}
+
+static void bench_range(int range) {
+    // Read through a volatile so the range is not a compile-time constant
+    volatile int max = range - 1;
+    long acc = 0;
+    clock_t start;
+
+    start = clock();
+    for (long i = 0; i < BENCH_OPS; i++) acc += old_int_range(&state, 0, max);
+    double old = mops(start);
+
+    start = clock();
+    for (long i = 0; i < BENCH_OPS; i++) acc += random_int_range(&state, 0, max);
+    double int_range = mops(start);
+
+    start = clock();
+    for (long i = 0; i < BENCH_OPS; i++) acc += random_bounded32(&state, (uint32_t)max + 1);
+    double bounded32 = mops(start);
+
+    start = clock();
+    for (long i = 0; i < BENCH_OPS; i++) acc += (long)random_bounded64(&state, (uint64_t)max + 1);
+    double bounded64 = mops(start);
+
+    sink += acc;
+    printf("range %-8d old %6.1f  int_range %6.1f  bounded32 %6.1f  bounded64 %6.1f Mops/s\n",
+           range, old, int_range, bounded32, bounded64);
+}
+
+void bench_small_range(void) {
+    bench_range(2);
+}
+
+void bench_medium_range(void) {
+    bench_range(100);
+}
+
+void bench_large_range(void) {
+    bench_range(1000000);
+}
+
+void test_int_range_is_uniform(void) {
+    long counts[7] = { 0 };
+    const long samples = 7000000;
+
+    for (long i = 0; i < samples; i++) {
+        counts[random_int_range(&state, -3, 3) + 3]++;
+    }
+
+    double expected = samples / 7.0;
+    double chi2 = 0;
+    for (int i = 0; i < 7; i++) {
+        chi2 += (counts[i] - expected) * (counts[i] - expected) / expected;
+    }
+
+    // 6 degrees of freedom, p = 0.001
+    TEST_ASSERT_TRUE(chi2 < 22.46);
+}
+
+void test_bounded64_is_uniform_for_a_large_range(void) {
+    // A range just above 2/3 of 2^64 rejects often, so a biased rejection shows
+    const uint64_t range = 0xAAAAAAAAAAAAAAABULL;
+    const uint64_t third = range / 3 + 1;
+    long counts[3] = { 0 };
+    const long samples = 3000000;
+
+    for (long i = 0; i < samples; i++) {
+        counts[random_bounded64(&state, range) / third]++;
+    }
+
+    double expected = samples / 3.0;
+    double chi2 = 0;
+    for (int i = 0; i < 3; i++) {
+        chi2 += (counts[i] - expected) * (counts[i] - expected) / expected;
+    }
+
+    // 2 degrees of freedom, p = 0.001
+    TEST_ASSERT_TRUE(chi2 < 13.82);
+}
+
+void test_int_range_covers_the_full_int_range(void) {
+    int lo = INT_MAX;
+    int hi = INT_MIN;
+
+    for (long i = 0; i < 1000000; i++) {
+        int value = random_int_range(&state, INT_MIN, INT_MAX);
+
+        if (value < lo) lo = value;
+        if (value > hi) hi = value;
+    }
+
+    TEST_ASSERT_TRUE(lo < INT_MIN / 2);
+    TEST_ASSERT_TRUE(hi > INT_MAX / 2);
+    TEST_ASSERT_EQUAL_INT(5, random_int_range(&state, 5, 5));
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    RUN_TEST(bench_small_range);
+    RUN_TEST(bench_medium_range);
+    RUN_TEST(bench_large_range);
+    RUN_TEST(test_int_range_is_uniform);
+    RUN_TEST(test_bounded64_is_uniform_for_a_large_range);
+    RUN_TEST(test_int_range_covers_the_full_int_range);
+    return UNITY_END();
+}
@@ -0,0 +1,191 @@
+/**
+ * Host benchmark and distribution checks for the Ziggurat sampler
+ * Compares random_normal() and random_exponential() with the polar
+ * Box-Muller and inverse transform code they replaced, then checks the
+ * Ziggurat output with chi-square tests. Host numbers only compare the
+ * methods, they are not AVR timings.
+ *
+ * Run with: pio test -e native -f bench_random_ziggurat -v
+ */
+
+#include <unity.h>
+#include <stdio.h>
+#include <math.h>
+#include <time.h>
+#include "random.h"
+
+#define BENCH_SAMPLES 20000000L
+#define CHECK_SAMPLES 20000000L
+
+static random_state_t state;
+static volatile double sink;
+
+void setUp(void) {
+    random_init_with_seed(&state, 99);
+}
+
+void tearDown(void) {}
+
+/**
+ * The previous normal sampler, polar Box-Muller with a cached spare value
+ */
+__attribute__((noinline)) static double old_normal(random_state_t* s) {
+    static int hasSpare = 0;
+    static double spare;
+    double u, v, r;
+
+    if (hasSpare) {
+        hasSpare = 0;
+        return spare;
+    }
+
+    do {
+        u = random_double(s) * 2.0 - 1.0;
+        v = random_double(s) * 2.0 - 1.0;
+        r = u * u + v * v;
+    } while (r >= 1.0 || r == 0.0);
+
+    r = sqrt(-2.0 * log(r) / r);
+    spare = v * r;
+    hasSpare = 1;
+
+    return u * r;
+}
+
+/**
+ * The previous exponential sampler, inverse transform
+ */
+__attribute__((noinline)) static double old_exponential(random_state_t* s) {
+    double u;
+
+    do {
+        u = random_double(s);
+    } while (u == 0.0);
+
+    return -log(u);
+}
+
+static double msamples(clock_t start) {
+    return BENCH_SAMPLES / ((double)(clock() - start) / CLOCKS_PER_SEC) / 1e6;
+}
+
+void bench_normal(void) {
+    double acc = 0;
+    clock_t start;
+
+    start = clock();
+    for (long i = 0; i < BENCH_SAMPLES; i++) acc += old_normal(&state);
+    double old = msamples(start);
+
+    start = clock();
+    for (long i = 0; i < BENCH_SAMPLES; i++) acc += random_normal(&state);
+    double ziggurat = msamples(start);
+
+    sink += acc;
+    printf("normal       Box-Muller %6.1f  Ziggurat %6.1f Msamples/s\n", old, ziggurat);
+}
+
+void bench_exponential(void) {
+    double acc = 0;
+    clock_t start;
+
+    start = clock();
+    for (long i = 0; i < BENCH_SAMPLES; i++) acc += old_exponential(&state);
+    double old = msamples(start);
+
+    start = clock();
+    for (long i = 0; i < BENCH_SAMPLES; i++) acc += random_exponential(&state);
+    double ziggurat = msamples(start);
+
+    sink += acc;
+    printf("exponential  inverse    %6.1f  Ziggurat %6.1f Msamples/s\n", old, ziggurat);
+}
+
+void test_normal_chi_square(void) {
+    // 80 bins of 0.1 over [-4, 4), the outer bins take the tails
+    static long bins[80];
+    double chi2 = 0;
+
+    for (long i = 0; i < CHECK_SAMPLES; i++) {
+        int bin = (int)floor((random_normal(&state) + 4.0) * 10.0);
+
+        if (bin < 0) bin = 0;
+        if (bin > 79) bin = 79;
+        bins[bin]++;
+    }
+
+    for (int bin = 0; bin < 80; bin++) {
+        double lo = bin == 0 ? -INFINITY : bin / 10.0 - 4.0;
+        double hi = bin == 79 ? INFINITY : (bin + 1) / 10.0 - 4.0;
+        double expected = 0.5 * (erf(hi / sqrt(2.0)) - erf(lo / sqrt(2.0))) * CHECK_SAMPLES;
+
+        chi2 += (bins[bin] - expected) * (bins[bin] - expected) / expected;
+    }
+
+    printf("normal chi2 %.1f on 79 degrees of freedom\n", chi2);
+
+    // p = 0.001
+    TEST_ASSERT_TRUE(chi2 < 119.0);
+}
+
+void test_exponential_chi_square(void) {
+    // 100 bins of 0.1 over [0, 10), the last bin takes the tail
+    static long bins[100];
+    double chi2 = 0;
+
+    for (long i = 0; i < CHECK_SAMPLES; i++) {
+        double x = random_exponential(&state);
+        int bin = x >= 9.9 ? 99 : (int)(x * 10.0);
+
+        TEST_ASSERT_TRUE(x >= 0.0);
+        bins[bin]++;
+    }
+
+    for (int bin = 0; bin < 100; bin++) {
+        double p = bin == 99 ? exp(-9.9) : exp(-bin / 10.0) - exp(-(bin + 1) / 10.0);
+        double expected = p * CHECK_SAMPLES;
+
+        chi2 += (bins[bin] - expected) * (bins[bin] - expected) / expected;
+    }
+
+    printf("exponential chi2 %.1f on 99 degrees of freedom\n", chi2);
+
+    // p = 0.001
+    TEST_ASSERT_TRUE(chi2 < 148.2);
+}
+
+void test_normal_moments(void) {
+    double sum = 0;
+    double squares = 0;
+    long tail = 0;
+
+    for (long i = 0; i < CHECK_SAMPLES; i++) {
+        double x = random_normal(&state);
+
+        sum += x;
+        squares += x * x;
+        if (fabs(x) > 4.0) tail++;
+    }
+
+    double mean = sum / CHECK_SAMPLES;
+    double variance = squares / CHECK_SAMPLES - mean * mean;
+    double tailRate = (double)tail / CHECK_SAMPLES;
+
+    printf("normal mean %.5f variance %.5f P(|x| > 4) %.3g\n", mean, variance, tailRate);
+
+    // Unity is built without double support, so compare by hand
+    TEST_ASSERT_TRUE(fabs(mean) < 0.002);
+    TEST_ASSERT_TRUE(fabs(variance - 1.0) < 0.003);
+    // P(|x| > 4) is 6.3e-5, the tail past the base layer must still be sampled
+    TEST_ASSERT_TRUE(fabs(tailRate - 6.33e-5) < 1.5e-5);
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    RUN_TEST(bench_normal);
+    RUN_TEST(bench_exponential);
+    RUN_TEST(test_normal_chi_square);
+    RUN_TEST(test_exponential_chi_square);
+    RUN_TEST(test_normal_moments);
+    return UNITY_END();
+}
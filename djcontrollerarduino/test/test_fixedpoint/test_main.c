@@ -0,0 +1,89 @@
+/**
+ * Host tests for the fixed-point library
+ *
+ * Run with: pio test -e native -f test_fixedpoint
+ */
+
+#include <unity.h>
+#include <stdlib.h>
+#include "fixedpoint.h"
+
+void setUp(void) {}
+void tearDown(void) {}
+
+/**
+ * Compare map_value_scaled() with map_value() for every input of a range
+ * @return Number of inputs that gave a different result
+ */
+static uint32_t count_mismatches(int16_t in_min, int16_t in_max, int16_t out_min, int16_t out_max) {
+    MapScale scale;
+    uint32_t mismatches = 0;
+
+    TEST_ASSERT_TRUE(map_scale_init(&scale, in_min, in_max, out_min, out_max));
+
+    int16_t lo = in_min < in_max ? in_min : in_max;
+    int16_t hi = in_min < in_max ? in_max : in_min;
+
+    for (int16_t x = lo; x <= hi; x++) {
+        if (map_value(x, in_min, in_max, out_min, out_max) != map_value_scaled(&scale, x)) {
+            mismatches++;
+        }
+    }
+
+    return mismatches;
+}
+
+void test_scaled_matches_map_value_for_all_adc_spans(void) {
+    // Every input span the ADC can produce, every x, against a spread of output spans
+    for (int16_t in_max = 1; in_max <= 1023; in_max++) {
+        for (int16_t out_max = 0; out_max <= 4095; out_max += (out_max < 128 ? 1 : 61)) {
+            TEST_ASSERT_EQUAL_UINT32(0, count_mismatches(0, in_max, 0, out_max));
+        }
+    }
+}
+
+void test_scaled_matches_map_value_for_offset_and_reversed_ranges(void) {
+    static const int16_t inputs[][2] = {
+        {0, 1023}, {1023, 0}, {0, 1022}, {5, 1000}, {0, 100}, {0, 1}, {-512, 511}
+    };
+
+    for (uint8_t r = 0; r < sizeof(inputs) / sizeof(inputs[0]); r++) {
+        for (int16_t out_min = -300; out_min <= 300; out_min += 7) {
+            for (int16_t out_max = -4000; out_max <= 4000; out_max += 1 + abs(out_max) / 50) {
+                if (abs(out_max - out_min) > 4095) {
+                    continue;
+                }
+                TEST_ASSERT_EQUAL_UINT32(0, count_mismatches(inputs[r][0], inputs[r][1], out_min, out_max));
+            }
+        }
+    }
+}
+
+void test_scaled_clamps_outside_input_range(void) {
+    MapScale scale;
+
+    TEST_ASSERT_TRUE(map_scale_init(&scale, 100, 900, 0, 1000));
+    TEST_ASSERT_EQUAL_INT16(0, map_value_scaled(&scale, 0));
+    TEST_ASSERT_EQUAL_INT16(1000, map_value_scaled(&scale, 1023));
+
+    TEST_ASSERT_TRUE(map_scale_init(&scale, 900, 100, 0, 1000));
+    TEST_ASSERT_EQUAL_INT16(0, map_value_scaled(&scale, 1023));
+    TEST_ASSERT_EQUAL_INT16(1000, map_value_scaled(&scale, 0));
+}
+
+void test_scale_init_rejects_unsupported_ranges(void) {
+    MapScale scale;
+
+    TEST_ASSERT_FALSE(map_scale_init(&scale, 10, 10, 0, 100));
+    TEST_ASSERT_FALSE(map_scale_init(&scale, 0, 1024, 0, 100));
+    TEST_ASSERT_FALSE(map_scale_init(&scale, 0, 1023, 0, 4096));
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_scaled_matches_map_value_for_all_adc_spans);
+    RUN_TEST(test_scaled_matches_map_value_for_offset_and_reversed_ranges);
+    RUN_TEST(test_scaled_clamps_outside_input_range);
+    RUN_TEST(test_scale_init_rejects_unsupported_ranges);
+    return UNITY_END();
+}
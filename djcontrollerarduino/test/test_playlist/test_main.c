@@ -0,0 +1,224 @@
+/**
+ * Host tests for the playlist library
+ *
+ * Run with: pio test -e native -f test_playlist
+ */
+
+#include <unity.h>
+#include "playlist.h"
+#include "random.h"
+
+// The playlist only needs these two from the display and systick drivers
+void display_string(const char* str) {
+    (void)str;
+}
+
+uint32_t systick_millis(void) {
+    return 0;
+}
+
+static Playlist* playlist;
+
+void setUp(void) {
+    playlist = playlist_create(PLAYLIST_MAX_TRACKS);
+    TEST_ASSERT_NOT_NULL(playlist);
+}
+
+void tearDown(void) {
+    playlist_destroy(playlist);
+}
+
+static void fill(uint8_t count) {
+    playlist_clear(playlist);
+    for (uint8_t i = 0; i < count; i++) {
+        TEST_ASSERT_TRUE(playlist_append_track(playlist, PLAYLIST_DEFAULT_DURATION));
+    }
+}
+
+void test_next_wraps_for_every_length(void) {
+    fill(1);
+    TEST_ASSERT_FALSE(playlist_next_track(playlist));
+
+    for (uint8_t count = 2; count <= PLAYLIST_MAX_TRACKS; count++) {
+        fill(count);
+
+        for (uint16_t step = 0; step < 2 * count; step++) {
+            uint8_t before = playlist->current_index;
+
+            TEST_ASSERT_TRUE(playlist_next_track(playlist));
+            TEST_ASSERT_EQUAL_UINT8((before + 1) % count, playlist->current_index);
+        }
+    }
+}
+
+void test_prev_without_history_wraps(void) {
+    fill(5);
+
+    TEST_ASSERT_TRUE(playlist_prev_track(playlist));
+    TEST_ASSERT_EQUAL_UINT8(4, playlist->current_index);
+    TEST_ASSERT_TRUE(playlist_prev_track(playlist));
+    TEST_ASSERT_EQUAL_UINT8(3, playlist->current_index);
+}
+
+void test_prev_pops_history_newest_first(void) {
+    uint8_t visited[PLAYLIST_RING_SIZE + 1];
+
+    fill(20);
+    visited[0] = playlist->current_index;
+    for (uint8_t i = 1; i <= PLAYLIST_RING_SIZE; i++) {
+        TEST_ASSERT_TRUE(playlist_set_current_track(playlist, (i * 7) % 20));
+        visited[i] = playlist->current_index;
+    }
+
+    for (int8_t i = PLAYLIST_RING_SIZE - 1; i >= 0; i--) {
+        TEST_ASSERT_TRUE(playlist_prev_track(playlist));
+        TEST_ASSERT_EQUAL_UINT8(visited[i], playlist->current_index);
+    }
+}
+
+void test_queue_plays_in_order_before_next(void) {
+    static const uint8_t queued[] = { 7, 2, 9, 2 };
+
+    fill(10);
+    TEST_ASSERT_TRUE(playlist_set_current_track(playlist, 4));
+    for (uint8_t i = 0; i < sizeof(queued); i++) {
+        TEST_ASSERT_TRUE(playlist_enqueue(playlist, queued[i]));
+    }
+
+    for (uint8_t i = 0; i < sizeof(queued); i++) {
+        TEST_ASSERT_TRUE(playlist_next_track(playlist));
+        TEST_ASSERT_EQUAL_UINT8(queued[i], playlist->current_index);
+    }
+
+    // Back to playlist order after the queue
+    TEST_ASSERT_TRUE(playlist_next_track(playlist));
+    TEST_ASSERT_EQUAL_UINT8(3, playlist->current_index);
+}
+
+void test_queue_rejects_invalid_and_overflow(void) {
+    fill(10);
+
+    TEST_ASSERT_FALSE(playlist_enqueue(playlist, 10));
+    for (uint8_t i = 0; i < PLAYLIST_RING_SIZE; i++) {
+        TEST_ASSERT_TRUE(playlist_enqueue(playlist, i % 10));
+    }
+    TEST_ASSERT_FALSE(playlist_enqueue(playlist, 0));
+}
+
+void test_shuffle_cycles_are_permutations(void) {
+    for (uint8_t count = 2; count <= 40; count++) {
+        fill(count);
+        playlist_set_shuffle(playlist, 1);
+
+        for (uint8_t cycle = 0; cycle < 20; cycle++) {
+            uint8_t seen[PLAYLIST_MAX_TRACKS] = { 0 };
+            uint8_t step = 0;
+
+            // The first cycle starts at the track that was current
+            if (cycle == 0) {
+                seen[playlist->current_index] = 1;
+                step = 1;
+            }
+
+            for (; step < count; step++) {
+                uint8_t before = playlist->current_index;
+
+                TEST_ASSERT_TRUE(playlist_next_track(playlist));
+                TEST_ASSERT_NOT_EQUAL(before, playlist->current_index);
+                TEST_ASSERT_FALSE(seen[playlist->current_index]);
+                seen[playlist->current_index] = 1;
+            }
+        }
+
+        playlist_set_shuffle(playlist, 0);
+    }
+}
+
+void test_set_rejects_out_of_range(void) {
+    fill(10);
+
+    for (uint16_t index = 10; index < 256; index++) {
+        TEST_ASSERT_FALSE(playlist_set_current_track(playlist, index));
+    }
+    TEST_ASSERT_TRUE(playlist_set_current_track(playlist, 9));
+    TEST_ASSERT_EQUAL_UINT8(9, playlist->current_index);
+}
+
+void test_add_stops_at_capacity(void) {
+    fill(PLAYLIST_MAX_TRACKS);
+
+    TEST_ASSERT_FALSE(playlist_append_track(playlist, PLAYLIST_DEFAULT_DURATION));
+    TEST_ASSERT_EQUAL_UINT8(PLAYLIST_MAX_TRACKS, playlist->count);
+}
+
+void test_remove_clamps_current_index(void) {
+    fill(30);
+    TEST_ASSERT_TRUE(playlist_set_current_track(playlist, 29));
+
+    while (playlist->count > 0) {
+        TEST_ASSERT_TRUE(playlist_remove_last_track(playlist));
+        if (playlist->count > 0) {
+            TEST_ASSERT_EQUAL_UINT8(playlist->count - 1, playlist->current_index);
+        }
+    }
+
+    TEST_ASSERT_EQUAL_UINT8(0, playlist->current_index);
+    TEST_ASSERT_FALSE(playlist_remove_last_track(playlist));
+}
+
+void test_name_pack_round_trip(void) {
+    char buffer[PLAYLIST_NAME_LENGTH + 1];
+
+    fill(3);
+
+    TEST_ASSERT_TRUE(playlist_set_name(playlist, 1, "ab12 cd3"));
+    TEST_ASSERT_EQUAL_UINT8(8, playlist_get_name(playlist, 1, buffer));
+    TEST_ASSERT_EQUAL_STRING("AB12 CD3", buffer);
+
+    // Characters the display cannot show become spaces, long names are cut
+    TEST_ASSERT_TRUE(playlist_set_name(playlist, 1, "x-y_z0123456"));
+    TEST_ASSERT_EQUAL_UINT8(8, playlist_get_name(playlist, 1, buffer));
+    TEST_ASSERT_EQUAL_STRING("X Y Z012", buffer);
+
+    TEST_ASSERT_TRUE(playlist_set_name(playlist, 1, "Z"));
+    TEST_ASSERT_EQUAL_UINT8(1, playlist_get_name(playlist, 1, buffer));
+    TEST_ASSERT_EQUAL_STRING("Z", buffer);
+}
+
+void test_name_is_held_for_one_track(void) {
+    char buffer[PLAYLIST_NAME_LENGTH + 1];
+
+    fill(3);
+    TEST_ASSERT_TRUE(playlist_set_name(playlist, 1, "FIRST"));
+    TEST_ASSERT_TRUE(playlist_set_name(playlist, 2, "SECOND"));
+
+    TEST_ASSERT_EQUAL_UINT8(4, playlist_get_name(playlist, 1, buffer));
+    TEST_ASSERT_EQUAL_STRING("TR02", buffer);
+    TEST_ASSERT_EQUAL_UINT8(6, playlist_get_name(playlist, 2, buffer));
+    TEST_ASSERT_EQUAL_STRING("SECOND", buffer);
+
+    // An empty name goes back to the numbered one
+    TEST_ASSERT_TRUE(playlist_set_name(playlist, 2, ""));
+    playlist_get_name(playlist, 2, buffer);
+    TEST_ASSERT_EQUAL_STRING("TR03", buffer);
+
+    TEST_ASSERT_FALSE(playlist_set_name(playlist, 3, "GONE"));
+}
+
+int main(void) {
+    random_global_init();
+
+    UNITY_BEGIN();
+    RUN_TEST(test_next_wraps_for_every_length);
+    RUN_TEST(test_prev_without_history_wraps);
+    RUN_TEST(test_prev_pops_history_newest_first);
+    RUN_TEST(test_queue_plays_in_order_before_next);
+    RUN_TEST(test_queue_rejects_invalid_and_overflow);
+    RUN_TEST(test_shuffle_cycles_are_permutations);
+    RUN_TEST(test_set_rejects_out_of_range);
+    RUN_TEST(test_add_stops_at_capacity);
+    RUN_TEST(test_remove_clamps_current_index);
+    RUN_TEST(test_name_pack_round_trip);
+    RUN_TEST(test_name_is_held_for_one_track);
+    return UNITY_END();
+}
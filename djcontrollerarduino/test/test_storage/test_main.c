@@ -0,0 +1,172 @@
+/**
+ * Host tests for the EEPROM key-value log
+ * Runs against the RAM-emulated EEPROM of the PC build and cuts the power
+ * at random points of a write: each cut forgets everything in RAM and
+ * restarts from what the log holds.
+ *
+ * Run with: pio test -e native -f test_storage
+ */
+
+#include <unity.h>
+#include <stdlib.h>
+#include <string.h>
+#include "storage.h"
+
+#define TORTURE_WRITES 200000L
+#define HISTORY 64  // Recent values of a key, one of them must survive a cut
+
+void setUp(void) {
+    // Erased EEPROM reads 0xFF
+    memset(storage_host_eeprom, 0xFF, sizeof(storage_host_eeprom));
+    memset(storage_host_byte_writes, 0, sizeof(storage_host_byte_writes));
+    storage_init();
+}
+
+void tearDown(void) {}
+
+void test_empty_eeprom_has_no_values(void) {
+    uint32_t value;
+
+    for (uint8_t key = 0; key < STORAGE_MAX_KEYS; key++) {
+        TEST_ASSERT_FALSE(storage_get(key, &value));
+    }
+    TEST_ASSERT_FALSE(storage_set(STORAGE_MAX_KEYS, 1));
+}
+
+void test_values_survive_a_restart(void) {
+    uint32_t value;
+
+    TEST_ASSERT_TRUE(storage_set(STORAGE_KEY_PLAYLIST, 0x12345678UL));
+    TEST_ASSERT_TRUE(storage_set(STORAGE_KEY_SIMON_SCORE, 7));
+    TEST_ASSERT_TRUE(storage_set(STORAGE_KEY_PLAYLIST, 0xCAFEF00DUL));
+    storage_flush();
+
+    // The repeated key only took one record
+    TEST_ASSERT_EQUAL_UINT16(2, storage_writes());
+
+    storage_init();
+    TEST_ASSERT_TRUE(storage_get(STORAGE_KEY_PLAYLIST, &value));
+    TEST_ASSERT_EQUAL_HEX32(0xCAFEF00DUL, value);
+    TEST_ASSERT_TRUE(storage_get(STORAGE_KEY_SIMON_SCORE, &value));
+    TEST_ASSERT_EQUAL_UINT32(7, value);
+    TEST_ASSERT_FALSE(storage_get(STORAGE_KEY_NIM_SCORE, &value));
+}
+
+void test_corrupt_record_falls_back_to_older_one(void) {
+    uint32_t value;
+
+    storage_set(STORAGE_KEY_LED_BRIGHTNESS, 10);
+    storage_flush();
+    storage_set(STORAGE_KEY_LED_BRIGHTNESS, 20);
+    storage_flush();
+
+    // Flip a value bit of the newer record, in slot 1
+    storage_host_eeprom[STORAGE_START_ADDRESS + STORAGE_RECORD_SIZE + 3] ^= 0x01;
+
+    storage_init();
+    TEST_ASSERT_TRUE(storage_get(STORAGE_KEY_LED_BRIGHTNESS, &value));
+    TEST_ASSERT_EQUAL_UINT32(10, value);
+}
+
+static uint8_t in_history(const uint32_t* history, uint32_t value) {
+    for (uint8_t i = 0; i < HISTORY; i++) {
+        if (history[i] == value) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+void test_power_cuts_never_lose_a_value(void) {
+    // Two keys written all the time, two written once and left alone. The
+    // sequence numbers wrap several times, so the cold records must be
+    // refreshed to stay comparable
+    static const uint8_t hotKeys[2] = { STORAGE_KEY_PLAYLIST, STORAGE_KEY_LED_BRIGHTNESS };
+    static uint32_t history[2][HISTORY];
+    uint32_t value;
+    uint8_t historyPos[2] = { 0, 0 };
+    long cuts = 0;
+
+    srand(1);
+
+    storage_set(STORAGE_KEY_NIM_SCORE, 0x00030005UL);
+    storage_set(STORAGE_KEY_SIMON_SCORE, 12);
+    storage_flush();
+
+    for (long i = 0; i < TORTURE_WRITES; i++) {
+        uint8_t hot = rand() % 2;
+        uint32_t newValue = (uint32_t)rand();
+
+        storage_set(hotKeys[hot], newValue);
+        history[hot][historyPos[hot]++ % HISTORY] = newValue;
+
+        // Stop anywhere, also in the middle of a record
+        for (int step = rand() % 12; step > 0; step--) {
+            storage_poll();
+        }
+
+        if (rand() % 50 != 0) {
+            continue;
+        }
+
+        cuts++;
+        storage_init();
+
+        TEST_ASSERT_TRUE(storage_get(STORAGE_KEY_NIM_SCORE, &value));
+        TEST_ASSERT_EQUAL_HEX32(0x00030005UL, value);
+        TEST_ASSERT_TRUE(storage_get(STORAGE_KEY_SIMON_SCORE, &value));
+        TEST_ASSERT_EQUAL_UINT32(12, value);
+
+        // A hot key may lose its newest values, but never comes back as garbage
+        for (uint8_t k = 0; k < 2; k++) {
+            if (storage_get(hotKeys[k], &value)) {
+                TEST_ASSERT_TRUE(in_history(history[k], value));
+            }
+        }
+    }
+
+    TEST_ASSERT_TRUE(cuts > 1000);
+
+    storage_set(hotKeys[0], 42);
+    storage_flush();
+    storage_init();
+    TEST_ASSERT_TRUE(storage_get(hotKeys[0], &value));
+    TEST_ASSERT_EQUAL_UINT32(42, value);
+}
+
+void test_writes_are_spread_over_all_slots(void) {
+    uint32_t records = 0;
+
+    srand(2);
+
+    for (long i = 0; i < TORTURE_WRITES; i++) {
+        storage_set(STORAGE_KEY_PLAYLIST, (uint32_t)rand());
+        storage_flush();
+        records++;
+    }
+
+    // A slot is written once per STORAGE_SLOTS - STORAGE_MAX_KEYS records at
+    // most, and its key byte twice each time
+    uint32_t limit = 2 * (records / (STORAGE_SLOTS - STORAGE_MAX_KEYS) + 1);
+    uint32_t least = 0xFFFFFFFFUL;
+
+    for (uint16_t i = STORAGE_START_ADDRESS; i < STORAGE_HOST_EEPROM_SIZE; i++) {
+        TEST_ASSERT_TRUE(storage_host_byte_writes[i] <= limit);
+        if (storage_host_byte_writes[i] < least) {
+            least = storage_host_byte_writes[i];
+        }
+    }
+
+    // The sequence number bytes change on every pass, so no slot is skipped
+    TEST_ASSERT_TRUE(least > 0);
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_empty_eeprom_has_no_values);
+    RUN_TEST(test_values_survive_a_restart);
+    RUN_TEST(test_corrupt_record_falls_back_to_older_one);
+    RUN_TEST(test_power_cuts_never_lose_a_value);
+    RUN_TEST(test_writes_are_spread_over_all_slots);
+    return UNITY_END();
+}
@@ -9,12 +9,27 @@ import java.io.InputStream;
 import java.io.OutputStream;
 import java.util.ArrayList;
 import java.util.List;
+import java.util.function.BiConsumer;
 import java.util.function.Consumer;
 
 /**
  * Model class - handles Arduino communication with single-byte commands
  */
 public class ArduinoModel {
+    // Control slots reported in 'K' frames, must match potentiometer.h
+    public static final int CONTROL_SEEK = 0;
+    public static final int CONTROL_VOLUME = 1;
+    public static final int CONTROL_BPM = 2;
+    public static final int CONTROL_CROSSFADE = 3;
+    public static final int CONTROL_EQ = 4;
+
+    // Beats sent to lock the Arduino's beat loop, then one correction every few beats
+    private static final int BEAT_SYNC_WARMUP = 8;
+    private static final int BEAT_SYNC_INTERVAL = 4;
+
+    // Pause after each metadata frame, so the Arduino's receive buffer never holds more than one
+    private static final int METADATA_FRAME_GAP_MS = 30;
+
     private SerialPort comPort;
     private OutputStream output;
     private InputStream input;
@@ -25,7 +40,12 @@ public class ArduinoModel {
     private Runnable nextTrackHandler;
     private Runnable prevTrackHandler;
     private Consumer<Integer> seekHandler;
+    private Consumer<Integer> absoluteSeekHandler;
+    private Consumer<Integer> trackJumpHandler;
+    private Consumer<Integer> cueSetHandler;
+    private Consumer<Integer> positionSeekHandler;
     private Runnable statusRequestHandler;
+    private BiConsumer<Integer, Integer> controlChangeHandler;
 
     private Consumer<String> statusChangeCallback;
 
@@ -35,6 +55,12 @@ public class ArduinoModel {
     private int lastSentCurrentTrack = 1;
     private int lastSentTotalTracks = 1;
 
+    // Multi-byte frames from the Arduino may be split over several serial events
+    private char frameCommand = 0;
+    private final byte[] frameBuffer = new byte[16];
+    private int frameLength = 0;
+    private int frameExpected = 0;
+
     /**
      * Get a list of available serial ports
      * @return List of port names
@@ -66,6 +92,11 @@ public class ArduinoModel {
             output = comPort.getOutputStream();
             input = comPort.getInputStream();
 
+            // Reset tracking variables, the Arduino reports its restored state while booting
+            lastSentPlayingState = false;
+            lastSentCurrentTrack = 1;
+            lastSentTotalTracks = 1;
+
             setupDataListener();
 
             if (statusChangeCallback != null) {
@@ -78,11 +109,6 @@ public class ArduinoModel {
                 Thread.currentThread().interrupt();
             }
 
-            // Reset tracking variables
-            lastSentPlayingState = false;
-            lastSentCurrentTrack = 1;
-            lastSentTotalTracks = 1;
-
             return true;
         } else {
             if (statusChangeCallback != null) {
@@ -145,6 +171,11 @@ public class ArduinoModel {
         if (data.length == 0) return;
 
         for (byte b : data) {
+            if (frameCommand != 0) {
+                collectFrameByte(b);
+                continue;
+            }
+
             char command = (char) b;
 
             debugLog("Received command: '" + command + "'");
@@ -203,6 +234,30 @@ public class ArduinoModel {
                     }
                     break;
 
+                case 'K': // Aggregated control report: slot mask + one value per slot
+                    startFrame(command, 1);
+                    break;
+
+                case 'A': // Absolute seek: position in permille, high byte first
+                    startFrame(command, 2);
+                    break;
+
+                case 'J': // Jump to a track picked by the Arduino's shuffle: track index
+                    startFrame(command, 1);
+                    break;
+
+                case 'c': // Set a cue point at the current position: cue number
+                    startFrame(command, 1);
+                    break;
+
+                case 'G': // Seek to a position in seconds, high byte first
+                    startFrame(command, 2);
+                    break;
+
+                case 'Y': // State restored from EEPROM: current track, total tracks, play state
+                    startFrame(command, 3);
+                    break;
+
                 default:
                     debugLog("Unknown command from Arduino: '" + command + "'");
                     break;
@@ -210,11 +265,120 @@ public class ArduinoModel {
         }
     }
 
+    /**
+     * Start collecting the payload of a multi-byte frame
+     * @param command Frame command byte
+     * @param expected Number of payload bytes known so far
+     */
+    private void startFrame(char command, int expected) {
+        frameCommand = command;
+        frameLength = 0;
+        frameExpected = expected;
+    }
+
+    /**
+     * Add a payload byte to the current frame and handle it once complete
+     * @param b Received byte
+     */
+    private void collectFrameByte(byte b) {
+        if (frameLength < frameBuffer.length) {
+            frameBuffer[frameLength] = b;
+        }
+        frameLength++;
+
+        if (frameCommand == 'K' && frameLength == 1) {
+            frameExpected = 1 + Integer.bitCount(b & 0xFF);
+        }
+
+        if (frameLength >= frameExpected) {
+            char command = frameCommand;
+            frameCommand = 0;
+            handleFrame(command);
+        }
+    }
+
+    /**
+     * Handle a completed multi-byte frame
+     * @param command Frame command byte
+     */
+    private void handleFrame(char command) {
+        switch (command) {
+            case 'K': {
+                int mask = frameBuffer[0] & 0xFF;
+                int index = 1;
+                for (int slot = 0; slot < 8; slot++) {
+                    if ((mask & (1 << slot)) == 0) continue;
+
+                    int value = frameBuffer[index++] & 0xFF;
+                    debugLog("Arduino control " + slot + " changed to " + value);
+                    if (controlChangeHandler != null) {
+                        controlChangeHandler.accept(slot, value);
+                    }
+                }
+                break;
+            }
+
+            case 'A': {
+                int permille = ((frameBuffer[0] & 0xFF) << 8) | (frameBuffer[1] & 0xFF);
+                debugLog("Arduino requests: SEEK TO " + permille + " permille");
+                if (absoluteSeekHandler != null && permille <= 1000) {
+                    absoluteSeekHandler.accept(permille);
+                }
+                break;
+            }
+
+            case 'J': {
+                int index = frameBuffer[0] & 0xFF;
+                debugLog("Arduino requests: JUMP TO TRACK " + (index + 1));
+                // The Arduino already shows this track, no 'C'/'V' steps are needed
+                lastSentCurrentTrack = index + 1;
+                if (trackJumpHandler != null) {
+                    new Thread(() -> {
+                        trackJumpHandler.accept(index);
+                    }).start();
+                }
+                break;
+            }
+
+            case 'c': {
+                int cue = frameBuffer[0] & 0xFF;
+                debugLog("Arduino requests: SET CUE " + (cue + 1));
+                if (cueSetHandler != null) {
+                    new Thread(() -> {
+                        cueSetHandler.accept(cue);
+                    }).start();
+                }
+                break;
+            }
+
+            case 'G': {
+                int seconds = ((frameBuffer[0] & 0xFF) << 8) | (frameBuffer[1] & 0xFF);
+                debugLog("Arduino requests: SEEK TO " + seconds + " s");
+                if (positionSeekHandler != null) {
+                    positionSeekHandler.accept(seconds);
+                }
+                break;
+            }
+
+            case 'Y': {
+                lastSentCurrentTrack = frameBuffer[0] & 0xFF;
+                lastSentTotalTracks = frameBuffer[1] & 0xFF;
+                lastSentPlayingState = frameBuffer[2] != 0;
+                debugLog("Arduino restored track " + lastSentCurrentTrack + "/" + lastSentTotalTracks +
+                        (lastSentPlayingState ? ", playing" : ", paused"));
+                break;
+            }
+
+            default:
+                break;
+        }
+    }
+
     /**
      * Send a single byte command to Arduino
      * @param command Single character command
      */
-    private void sendSingleCommand(char command) {
+    private synchronized void sendSingleCommand(char command) {
         if (!isConnected) return;
 
         try {
@@ -229,6 +393,32 @@ public class ArduinoModel {
         }
     }
 
+    /**
+     * Send a command byte followed by its data bytes to Arduino
+     * @param command Command character
+     * @param values Data bytes (0-255 each)
+     */
+    private synchronized void sendFrame(char command, int... values) {
+        if (!isConnected) return;
+
+        byte[] frame = new byte[1 + values.length];
+        frame[0] = (byte) command;
+        for (int i = 0; i < values.length; i++) {
+            frame[i + 1] = (byte) values[i];
+        }
+
+        try {
+            output.write(frame);
+            output.flush();
+            Thread.sleep(10);
+            debugLog("Sent command to Arduino: '" + command + "' with " + values.length + " data bytes");
+        } catch (IOException e) {
+            handleSendError("command '" + command + "'", e);
+        } catch (InterruptedException e) {
+            Thread.currentThread().interrupt();
+        }
+    }
+
     /**
      * Send playing status to Arduino
      * @param isPlaying Whether the track is playing
@@ -311,26 +501,17 @@ public class ArduinoModel {
     }
 
     /**
-     * Send track change notification (when track changes in Java)
-     * @param isNext True for next track, false for previous
+     * Send a previous track notification (when the track goes back in Java)
+     * The Arduino pops its play history, the same way Java went back, so
+     * the new track need not be the neighbour of the old one
+     * @param index New track index (0-based)
      * @param currentlyPlaying Current playing state after track change
      */
-    public void sendTrackChange(boolean isNext, boolean currentlyPlaying) {
+    public void sendPreviousTrack(int index, boolean currentlyPlaying) {
         if (!isConnected) return;
 
-        if (isNext) {
-            sendSingleCommand('N');
-            lastSentCurrentTrack++;
-            if (lastSentCurrentTrack > lastSentTotalTracks) {
-                lastSentCurrentTrack = 1;
-            }
-        } else {
-            sendSingleCommand('B');
-            lastSentCurrentTrack--;
-            if (lastSentCurrentTrack < 1) {
-                lastSentCurrentTrack = lastSentTotalTracks;
-            }
-        }
+        sendSingleCommand('B');
+        lastSentCurrentTrack = index + 1;
 
         try {
             Thread.sleep(50);
@@ -341,14 +522,105 @@ public class ArduinoModel {
         lastSentPlayingState = !currentlyPlaying;
         sendPlayStatus(currentlyPlaying);
 
-        debugLog("Sent track change: " + (isNext ? "NEXT" : "PREVIOUS") + " with play state: " + currentlyPlaying);
+        debugLog("Sent previous track " + (index + 1) + " with play state: " + currentlyPlaying);
+    }
+
+    /**
+     * Tell the Arduino the current track changed to any track
+     * The Arduino adds the track that was left to its play history
+     * @param index New track index (0-based)
+     */
+    public void sendTrackJump(int index) {
+        if (!isConnected) return;
+
+        sendFrame('J', index);
+        lastSentCurrentTrack = index + 1;
+    }
+
+    /**
+     * Add a track to the Arduino's up-next queue
+     * @param index Track index (0-based)
+     */
+    public void sendEnqueueTrack(int index) {
+        if (!isConnected) return;
+        sendFrame('U', index);
+    }
+
+    /**
+     * Send a track's duration and display name to Arduino
+     * One frame per track, a playlist is sent as a series of these
+     * @param index Track index (0-based)
+     * @param durationSeconds Duration in seconds
+     * @param displayName Name of up to 8 letters, digits and spaces; only used for the current track
+     */
+    public void sendTrackMetadata(int index, int durationSeconds, String displayName) {
+        if (!isConnected) return;
+
+        int duration = Math.max(0, Math.min(durationSeconds, 0xFFFF));
+        int length = Math.min(displayName.length(), PlaylistModel.DISPLAY_NAME_LENGTH);
+
+        int[] values = new int[4 + length];
+        values[0] = index;
+        values[1] = duration >> 8;
+        values[2] = duration & 0xFF;
+        values[3] = length;
+        for (int i = 0; i < length; i++) {
+            values[4 + i] = displayName.charAt(i);
+        }
+        sendFrame('M', values);
+
+        try {
+            Thread.sleep(METADATA_FRAME_GAP_MS);
+        } catch (InterruptedException e) {
+            Thread.currentThread().interrupt();
+        }
     }
 
     /**
-     * Send beat detected signal to Arduino
+     * Send the cue points of a track to Arduino
+     * The Arduino keeps the cue points of one track, so send them on every track change
+     * @param index Track index (0-based)
+     * @param cues Cue positions in seconds, negative if not set
      */
-    public void sendBeatDetected() {
+    public void sendCuePoints(int index, int[] cues) {
         if (!isConnected) return;
+
+        int[] values = new int[1 + 2 * PlaylistModel.CUE_COUNT];
+        values[0] = index;
+        for (int cue = 0; cue < PlaylistModel.CUE_COUNT; cue++) {
+            int seconds = (cue < cues.length && cues[cue] >= 0) ? Math.min(cues[cue], 0xFFFE) : 0xFFFF;
+            values[1 + 2 * cue] = seconds >> 8;
+            values[2 + 2 * cue] = seconds & 0xFF;
+        }
+        sendFrame('E', values);
+    }
+
+    /**
+     * Set the Arduino's LED brightness, it is kept over power cycles
+     * @param level Brightness ceiling (0-31)
+     */
+    public void sendLedBrightness(int level) {
+        if (!isConnected) return;
+        sendFrame('L', Math.max(0, Math.min(31, level)));
+    }
+
+    /**
+     * Make the Arduino forget its play history and up-next queue
+     */
+    public void sendClearHistory() {
+        if (!isConnected) return;
+        sendSingleCommand('H');
+    }
+
+    /**
+     * Send a beat to the Arduino for its beat tracking loop
+     * The first beats after a (re)start are all sent so the loop can lock,
+     * after that only every BEAT_SYNC_INTERVAL-th beat as a correction
+     * @param beatNumber Number of the beat since beat detection started
+     */
+    public void sendBeatDetected(int beatNumber) {
+        if (!isConnected) return;
+        if (beatNumber >= BEAT_SYNC_WARMUP && beatNumber % BEAT_SYNC_INTERVAL != 0) return;
         sendSingleCommand('b');
     }
 
@@ -430,10 +702,30 @@ public class ArduinoModel {
         this.seekHandler = handler;
     }
 
+    public void setAbsoluteSeekHandler(Consumer<Integer> handler) {
+        this.absoluteSeekHandler = handler;
+    }
+
+    public void setTrackJumpHandler(Consumer<Integer> handler) {
+        this.trackJumpHandler = handler;
+    }
+
+    public void setCueSetHandler(Consumer<Integer> handler) {
+        this.cueSetHandler = handler;
+    }
+
+    public void setPositionSeekHandler(Consumer<Integer> handler) {
+        this.positionSeekHandler = handler;
+    }
+
     public void setStatusRequestHandler(Runnable handler) {
         this.statusRequestHandler = handler;
     }
 
+    public void setControlChangeHandler(BiConsumer<Integer, Integer> handler) {
+        this.controlChangeHandler = handler;
+    }
+
     public void setStatusChangeCallback(Consumer<String> callback) {
         this.statusChangeCallback = callback;
     }
@@ -5,7 +5,10 @@ import javafx.scene.media.MediaPlayer;
 import javafx.util.Duration;
 
 import java.io.File;
+import java.util.ArrayDeque;
 import java.util.ArrayList;
+import java.util.Arrays;
+import java.util.Deque;
 import java.util.List;
 import java.util.Timer;
 import java.util.TimerTask;
@@ -16,9 +19,21 @@ import java.util.function.Consumer;
  * PlaylistModel class - handles the playlist and playback of audio tracks
  */
 public class PlaylistModel {
+    // Same as PLAYLIST_RING_SIZE on the Arduino, which mirrors the history and queue
+    private static final int RING_SIZE = 16;
+    // Same as PLAYLIST_CUES on the Arduino
+    public static final int CUE_COUNT = 4;
+    // Same as PLAYLIST_NAME_LENGTH on the Arduino
+    public static final int DISPLAY_NAME_LENGTH = 8;
+
     private final List<TrackInfo> tracks = new ArrayList<>();
     private int currentTrackIndex = 0;
 
+    // Tracks played before the current one, newest last
+    private final Deque<Integer> history = new ArrayDeque<>();
+    // Tracks to play before the next one in playlist order, oldest first
+    private final Deque<Integer> upNext = new ArrayDeque<>();
+
     private boolean isPlaying = false;
     private int currentPositionInSeconds = 0;
     private int volume = 50;
@@ -30,9 +45,11 @@ public class PlaylistModel {
     private Consumer<Integer> trackChangeCallback;
     private Consumer<Integer> positionChangeCallback;
     private Consumer<Integer> volumeChangeCallback;
-    private Runnable beatDetectedCallback;
+    private Consumer<Integer> beatDetectedCallback;
+    private Consumer<Integer> trackMetadataCallback;
 
     private Timer beatTimer;
+    private int beatNumber = 0;
     private int beatsPerMinute = 120;
 
     private Timer arduinoSyncTimer;
@@ -46,10 +63,12 @@ public class PlaylistModel {
         private final String name;
         private int durationInSeconds;
         private Media media;
+        private final int[] cues = new int[CUE_COUNT];
 
         public TrackInfo(File file) {
             this.filepath = file.getAbsolutePath();
             this.name = file.getName();
+            Arrays.fill(cues, -1);
             try {
                 this.media = new Media(file.toURI().toString());
                 this.durationInSeconds = 180;
@@ -80,6 +99,10 @@ public class PlaylistModel {
             return media;
         }
 
+        public int[] getCues() {
+            return cues;
+        }
+
         @Override
         public String toString() {
             return name;
@@ -100,6 +123,39 @@ public class PlaylistModel {
     public void addTrack(File file) {
         TrackInfo track = new TrackInfo(file);
         tracks.add(track);
+        probeDuration(track);
+    }
+
+    /**
+     * Read a track's real duration without playing it
+     * The duration stays at the default until the media is ready
+     * @param track Track to probe
+     */
+    private void probeDuration(TrackInfo track) {
+        if (track.getMedia() == null) return;
+
+        try {
+            MediaPlayer probe = new MediaPlayer(track.getMedia());
+            probe.setOnReady(() -> {
+                track.setDurationInSeconds((int) track.getMedia().getDuration().toSeconds());
+                probe.dispose();
+                notifyTrackMetadata(track);
+            });
+            probe.setOnError(probe::dispose);
+        } catch (Exception e) {
+            System.err.println("Error reading duration of " + track.getFilepath());
+        }
+    }
+
+    /**
+     * Report a track whose metadata changed, if it is still in the playlist
+     * @param track Changed track
+     */
+    private void notifyTrackMetadata(TrackInfo track) {
+        int index = tracks.indexOf(track);
+        if (index >= 0 && trackMetadataCallback != null) {
+            trackMetadataCallback.accept(index);
+        }
     }
 
     /**
@@ -113,6 +169,8 @@ public class PlaylistModel {
             }
 
             tracks.remove(index);
+            history.clear();
+            upNext.clear();
 
             if (tracks.isEmpty()) {
                 currentTrackIndex = 0;
@@ -139,6 +197,8 @@ public class PlaylistModel {
         stop();
         tracks.clear();
         currentTrackIndex = 0;
+        history.clear();
+        upNext.clear();
     }
 
     /**
@@ -161,6 +221,28 @@ public class PlaylistModel {
         return "";
     }
 
+    /**
+     * Get the name of a track as shown on the Arduino display
+     * Letters and digits of the file name without extension, uppercase,
+     * other characters become spaces
+     * @param index Track index
+     * @return Up to DISPLAY_NAME_LENGTH characters, empty if invalid index
+     */
+    public String getTrackDisplayName(int index) {
+        String name = getTrackName(index);
+        int dot = name.lastIndexOf('.');
+        if (dot > 0) {
+            name = name.substring(0, dot);
+        }
+
+        String display = name.toUpperCase()
+                .replaceAll("[^A-Z0-9]+", " ")
+                .trim();
+        return display.length() > DISPLAY_NAME_LENGTH
+                ? display.substring(0, DISPLAY_NAME_LENGTH).trim()
+                : display;
+    }
+
     /**
      * Get the track duration at the specified index
      * @param index Track index
@@ -183,13 +265,33 @@ public class PlaylistModel {
 
     /**
      * Set the current track index
+     * A jump to the first up-next track takes it off the queue
      * @param index New track index
      */
     public void setCurrentTrackIndex(int index) {
+        if (!upNext.isEmpty() && upNext.peekFirst() == index) {
+            upNext.pollFirst();
+        }
+        changeTrack(index, true);
+    }
+
+    /**
+     * Change the current track
+     * @param index New track index
+     * @param remember Whether to push the track that is left onto the history
+     */
+    private void changeTrack(int index, boolean remember) {
         if (index >= 0 && index < tracks.size() && index != currentTrackIndex) {
             boolean wasPlaying = isPlaying;
             stop();
 
+            if (remember) {
+                history.addLast(currentTrackIndex);
+                if (history.size() > RING_SIZE) {
+                    history.removeFirst();
+                }
+            }
+
             currentTrackIndex = index;
             currentPositionInSeconds = 0;
 
@@ -212,17 +314,25 @@ public class PlaylistModel {
     }
 
     /**
-     * Go to the next track in the playlist
+     * Go to the next track: the first up-next track, otherwise the next one in the playlist
      */
     public void nextTrack() {
         if (tracks.isEmpty()) return;
 
+        while (!upNext.isEmpty()) {
+            int index = upNext.pollFirst();
+            if (index < tracks.size() && index != currentTrackIndex) {
+                changeTrack(index, true);
+                return;
+            }
+        }
+
         int nextIndex = (currentTrackIndex + 1) % tracks.size();
-        setCurrentTrackIndex(nextIndex);
+        changeTrack(nextIndex, true);
     }
 
     /**
-     * Go to the previous track in the playlist
+     * Go back to the track played before, or the previous one in the playlist without history
      */
     public void previousTrack() {
         if (tracks.isEmpty()) return;
@@ -232,8 +342,75 @@ public class PlaylistModel {
             return;
         }
 
+        while (!history.isEmpty()) {
+            int index = history.pollLast();
+            if (index < tracks.size() && index != currentTrackIndex) {
+                changeTrack(index, false);
+                return;
+            }
+        }
+
         int prevIndex = (currentTrackIndex > 0) ? (currentTrackIndex - 1) : (tracks.size() - 1);
-        setCurrentTrackIndex(prevIndex);
+        changeTrack(prevIndex, false);
+    }
+
+    /**
+     * Add a track to the end of the up-next queue
+     * @param index Track index
+     * @return True if queued, false if the index is invalid or the queue is full
+     */
+    public boolean enqueueTrack(int index) {
+        if (index < 0 || index >= tracks.size() || upNext.size() >= RING_SIZE) {
+            return false;
+        }
+        upNext.addLast(index);
+        return true;
+    }
+
+    /**
+     * Get the up-next queue
+     * @return Track indices, the next one first
+     */
+    public List<Integer> getUpNext() {
+        return new ArrayList<>(upNext);
+    }
+
+    /**
+     * Set a cue point of a track
+     * @param index Track index
+     * @param cue Cue number (0 to CUE_COUNT - 1)
+     * @param positionInSeconds Cue position in seconds, negative to clear it
+     * @return True if set, false if the track or cue number is invalid
+     */
+    public boolean setCuePoint(int index, int cue, int positionInSeconds) {
+        if (index < 0 || index >= tracks.size() || cue < 0 || cue >= CUE_COUNT) {
+            return false;
+        }
+        tracks.get(index).getCues()[cue] = Math.max(-1, positionInSeconds);
+        return true;
+    }
+
+    /**
+     * Set a cue point of the current track at the playing position
+     * @param cue Cue number (0 to CUE_COUNT - 1)
+     * @return True if set
+     */
+    public boolean setCuePointAtCurrentPosition(int cue) {
+        return setCuePoint(currentTrackIndex, cue, getCurrentPositionInSeconds());
+    }
+
+    /**
+     * Get the cue points of a track
+     * @param index Track index
+     * @return Cue positions in seconds, -1 if not set
+     */
+    public int[] getCuePoints(int index) {
+        int[] cues = new int[CUE_COUNT];
+        Arrays.fill(cues, -1);
+        if (index >= 0 && index < tracks.size()) {
+            System.arraycopy(tracks.get(index).getCues(), 0, cues, 0, CUE_COUNT);
+        }
+        return cues;
     }
 
     /**
@@ -297,6 +474,14 @@ public class PlaylistModel {
      * @param percent Position as percentage (0-100)
      */
     public void seekByPercentage(int percent) {
+        seekByPercentage((double) percent);
+    }
+
+    /**
+     * Seek to a position by fractional percentage
+     * @param percent Position as percentage (0.0-100.0)
+     */
+    public void seekByPercentage(double percent) {
         if (tracks.isEmpty()) return;
 
         TrackInfo currentTrack = tracks.get(currentTrackIndex);
@@ -387,7 +572,10 @@ public class PlaylistModel {
             int durationSeconds = (int) duration.toSeconds();
 
             TrackInfo currentTrack = tracks.get(currentTrackIndex);
-            currentTrack.setDurationInSeconds(durationSeconds);
+            if (currentTrack.getDurationInSeconds() != durationSeconds) {
+                currentTrack.setDurationInSeconds(durationSeconds);
+                notifyTrackMetadata(currentTrack);
+            }
 
             if (positionChangeCallback != null) {
                 positionChangeCallback.accept(currentPositionInSeconds);
@@ -534,6 +722,28 @@ public class PlaylistModel {
         }
     }
 
+    /**
+     * Get the tempo used for beat detection
+     * @return Beats per minute
+     */
+    public int getBeatsPerMinute() {
+        return beatsPerMinute;
+    }
+
+    /**
+     * Set the tempo used for beat detection
+     * @param bpm Beats per minute (40-240)
+     */
+    public void setBeatsPerMinute(int bpm) {
+        if (bpm < 40 || bpm > 240 || bpm == beatsPerMinute) return;
+
+        beatsPerMinute = bpm;
+
+        if (isPlaying) {
+            startBeatDetection();
+        }
+    }
+
     /**
      * Set the callback for play state changes
      * @param callback Consumer that takes a boolean (isPlaying)
@@ -550,6 +760,14 @@ public class PlaylistModel {
         this.trackChangeCallback = callback;
     }
 
+    /**
+     * Set the callback for track metadata changes, e.g. a duration that became known
+     * @param callback Consumer that takes the track index
+     */
+    public void setTrackMetadataCallback(Consumer<Integer> callback) {
+        this.trackMetadataCallback = callback;
+    }
+
     /**
      * Set the callback for position changes
      * @param callback Consumer that takes the new position in seconds
@@ -568,9 +786,10 @@ public class PlaylistModel {
 
     /**
      * Set the callback for beat detection
-     * @param callback Runnable to be called when a beat is detected
+     * @param callback Called on every beat with the beat number, counted from 0
+     *                 each time beat detection (re)starts
      */
-    public void setBeatDetectedCallback(Runnable callback) {
+    public void setBeatDetectedCallback(Consumer<Integer> callback) {
         this.beatDetectedCallback = callback;
     }
 
@@ -584,13 +803,15 @@ public class PlaylistModel {
 
         beatTimer = new Timer("BeatDetection", true);
         long interval = (long)(60000.0 / beatsPerMinute);
+        beatNumber = 0;
 
         beatTimer.scheduleAtFixedRate(new TimerTask() {
             @Override
             public void run() {
                 if (beatDetectedCallback != null) {
-                    beatDetectedCallback.run();
+                    beatDetectedCallback.accept(beatNumber);
                 }
+                beatNumber++;
             }
         }, 0, interval);
     }
@@ -7,6 +7,8 @@ import main.java.djcontroller.view.DJControllerView;
 import java.io.File;
 import java.util.ArrayList;
 import java.util.List;
+import java.util.concurrent.ExecutorService;
+import java.util.concurrent.Executors;
 import java.util.concurrent.atomic.AtomicBoolean;
 
 /**
@@ -21,6 +23,13 @@ public class DJControllerPresenter {
     private final AtomicBoolean seekUpdateInProgress = new AtomicBoolean(false);
     private final AtomicBoolean volumeUpdateInProgress = new AtomicBoolean(false);
 
+    // Metadata frames are paced for the Arduino, so one background thread sends them in order
+    private final ExecutorService metadataSender = Executors.newSingleThreadExecutor(runnable -> {
+        Thread thread = new Thread(runnable, "ArduinoMetadata");
+        thread.setDaemon(true);
+        return thread;
+    });
+
     /**
      * Constructor
      *
@@ -52,6 +61,7 @@ public class DJControllerPresenter {
     private void setupModelCallbacks() {
         playlistModel.setPlayStateChangeCallback(this::handlePlayStateChange);
         playlistModel.setTrackChangeCallback(this::handleTrackChange);
+        playlistModel.setTrackMetadataCallback(index -> sendMetadataToArduino(index, index + 1));
         playlistModel.setPositionChangeCallback(this::handlePositionChange);
         playlistModel.setVolumeChangeCallback(this::handleVolumeChange);
         playlistModel.setBeatDetectedCallback(this::handleBeatDetected);
@@ -70,10 +80,7 @@ public class DJControllerPresenter {
 
             if (playlistModel.getCurrentTrackIndex() != oldTrack) {
                 javafx.application.Platform.runLater(() -> {
-                    arduinoModel.sendTrackInfo(
-                            playlistModel.getCurrentTrackIndex() + 1,
-                            playlistModel.getTrackCount()
-                    );
+                    arduinoModel.sendTrackJump(playlistModel.getCurrentTrackIndex());
                 });
             }
         });
@@ -86,16 +93,47 @@ public class DJControllerPresenter {
 
             if (playlistModel.getCurrentTrackIndex() != oldTrack) {
                 javafx.application.Platform.runLater(() -> {
-                    arduinoModel.sendTrackInfo(
-                            playlistModel.getCurrentTrackIndex() + 1,
-                            playlistModel.getTrackCount()
-                    );
+                    arduinoModel.sendPreviousTrack(playlistModel.getCurrentTrackIndex(), playlistModel.isPlaying());
                 });
             }
         });
 
+        arduinoModel.setTrackJumpHandler(index -> {
+            playlistModel.setCurrentTrackIndex(index);
+
+            javafx.application.Platform.runLater(() -> {
+                arduinoModel.sendTrackInfo(
+                        playlistModel.getCurrentTrackIndex() + 1,
+                        playlistModel.getTrackCount()
+                );
+            });
+        });
+
         arduinoModel.setSeekHandler(playlistModel::seekByRelativeSeconds);
 
+        arduinoModel.setAbsoluteSeekHandler(permille -> playlistModel.seekByPercentage(permille / 10.0));
+
+        arduinoModel.setPositionSeekHandler(playlistModel::seek);
+
+        arduinoModel.setCueSetHandler(cue -> {
+            if (playlistModel.setCuePointAtCurrentPosition(cue)) {
+                sendCuePointsToArduino();
+            }
+        });
+
+        arduinoModel.setControlChangeHandler((control, value) -> {
+            switch (control) {
+                case ArduinoModel.CONTROL_VOLUME:
+                    playlistModel.setVolume(value * 100 / 255);
+                    break;
+                case ArduinoModel.CONTROL_BPM:
+                    playlistModel.setBeatsPerMinute(60 + value * 120 / 255);
+                    break;
+                default:
+                    break;
+            }
+        });
+
         arduinoModel.setStatusRequestHandler(() -> {
             arduinoModel.sendTrackInfo(
                     playlistModel.getCurrentTrackIndex() + 1,
@@ -142,13 +180,20 @@ public class DJControllerPresenter {
 
         view.getClearButton().setOnAction(e -> onClearPlaylistRequest());
 
-        view.getPlaylistView().getSelectionModel().selectedIndexProperty().addListener(
-                (obs, oldValue, newValue) -> {
-                    if (newValue != null && newValue.intValue() >= 0) {
-                        onTrackSelected(newValue.intValue());
-                    }
-                }
-        );
+        view.getUpNextButton().setOnAction(e -> {
+            int selectedIndex = view.getPlaylistView().getSelectionModel().getSelectedIndex();
+            if (selectedIndex >= 0) {
+                onEnqueueTrackRequest(selectedIndex);
+            }
+        });
+
+        // A single click only selects, so a track can be picked for "Up Next"
+        view.getPlaylistView().setOnMouseClicked(e -> {
+            int selectedIndex = view.getPlaylistView().getSelectionModel().getSelectedIndex();
+            if (e.getClickCount() == 2 && selectedIndex >= 0) {
+                onTrackSelected(selectedIndex);
+            }
+        });
 
         view.getPlayButton().setOnAction(e -> {
             if (view.getPlayButton().getText().equals("▶")) {
@@ -180,6 +225,7 @@ public class DJControllerPresenter {
         });
 
         view.getPrimaryStage().setOnCloseRequest(e -> {
+            metadataSender.shutdownNow();
             onDisconnectRequest();
             playlistModel.stop();
             arduinoModel.sendPlayStatus(false);
@@ -275,6 +321,52 @@ public class DJControllerPresenter {
         } else {
             arduinoModel.resetTrackCounters();
         }
+        sendCuePointsToArduino();
+        sendMetadataToArduino(0, playlistModel.getTrackCount());
+    }
+
+    /**
+     * Send the duration of one track to Arduino, and the display name if it is the current track
+     * The Arduino only holds the current track's name, other tracks get an empty one
+     *
+     * @param index Track index
+     */
+    private void sendTrackMetadataToArduino(int index) {
+        boolean current = index == playlistModel.getCurrentTrackIndex();
+
+        arduinoModel.sendTrackMetadata(
+                index,
+                playlistModel.getTrackDuration(index),
+                current ? playlistModel.getTrackDisplayName(index) : ""
+        );
+    }
+
+    /**
+     * Send the metadata of a range of tracks in the background
+     *
+     * @param fromIndex First track to send
+     * @param toIndex   Track after the last one to send
+     */
+    private void sendMetadataToArduino(int fromIndex, int toIndex) {
+        if (!arduinoModel.isConnected()) return;
+
+        metadataSender.execute(() -> {
+            int count = Math.min(toIndex, playlistModel.getTrackCount());
+
+            for (int index = fromIndex; index < count; index++) {
+                sendTrackMetadataToArduino(index);
+            }
+        });
+    }
+
+    /**
+     * Send the cue points of the current track to Arduino
+     */
+    private void sendCuePointsToArduino() {
+        if (playlistModel.getTrackCount() == 0) return;
+
+        int index = playlistModel.getCurrentTrackIndex();
+        arduinoModel.sendCuePoints(index, playlistModel.getCuePoints(index));
     }
 
     /**
@@ -295,6 +387,13 @@ public class DJControllerPresenter {
      */
     private void handleTrackChange(int newTrackIndex) {
         updateTrackInfoView();
+
+        // The Arduino only holds the cue points and display name of one track
+        sendCuePointsToArduino();
+
+        // After the track jump that follows this callback, so the Arduino has moved
+        // to the track before its name arrives
+        javafx.application.Platform.runLater(() -> sendMetadataToArduino(newTrackIndex, newTrackIndex + 1));
     }
 
     /**
@@ -322,9 +421,11 @@ public class DJControllerPresenter {
 
     /**
      * Handle beat detected from model
+     *
+     * @param beatNumber Number of the beat since beat detection started
      */
-    private void handleBeatDetected() {
-        arduinoModel.sendBeatDetected();
+    private void handleBeatDetected(int beatNumber) {
+        arduinoModel.sendBeatDetected(beatNumber);
     }
 
     /**
@@ -380,6 +481,7 @@ public class DJControllerPresenter {
     private void onRemoveTrackRequest(int index) {
         playlistModel.removeTrack(index);
         updatePlaylistView();
+        arduinoModel.sendClearHistory();
 
         if (playlistModel.getTrackCount() > 0) {
             sendFullStatusToArduino();
@@ -397,17 +499,35 @@ public class DJControllerPresenter {
         updateTrackInfoView();
         updateTimeDisplay();
 
+        arduinoModel.sendClearHistory();
         arduinoModel.resetTrackCounters();
         arduinoModel.sendPlayStatus(false);
     }
 
+    /**
+     * Handle up-next request
+     *
+     * @param index Index of track to play next
+     */
+    private void onEnqueueTrackRequest(int index) {
+        if (playlistModel.enqueueTrack(index)) {
+            arduinoModel.sendEnqueueTrack(index);
+            view.showStatus("Up next: " + playlistModel.getTrackName(index));
+        }
+    }
+
     /**
      * Handle track selection
      *
      * @param index Index of selected track
      */
     private void onTrackSelected(int index) {
+        int oldIndex = playlistModel.getCurrentTrackIndex();
         playlistModel.setCurrentTrackIndex(index);
+
+        if (playlistModel.getCurrentTrackIndex() != oldIndex) {
+            arduinoModel.sendTrackJump(index);
+        }
     }
 
     /**
@@ -435,7 +555,7 @@ public class DJControllerPresenter {
         int newIndex = playlistModel.getCurrentTrackIndex();
 
         if (newIndex != oldIndex) {
-            arduinoModel.sendTrackChange(true, playlistModel.isPlaying());
+            arduinoModel.sendTrackJump(newIndex);
         }
     }
 
@@ -448,7 +568,7 @@ public class DJControllerPresenter {
         int newIndex = playlistModel.getCurrentTrackIndex();
 
         if (newIndex != oldIndex) {
-            arduinoModel.sendTrackChange(false, playlistModel.isPlaying());
+            arduinoModel.sendPreviousTrack(newIndex, playlistModel.isPlaying());
         }
     }
 
@@ -477,6 +597,7 @@ public class DJControllerPresenter {
      */
     private void onFilesSelected(List<File> files) {
         boolean wasEmpty = playlistModel.getTrackCount() == 0;
+        int firstNewIndex = playlistModel.getTrackCount();
 
         for (File file : files) {
             playlistModel.addTrack(file);
@@ -491,6 +612,7 @@ public class DJControllerPresenter {
                     playlistModel.getCurrentTrackIndex() + 1,
                     playlistModel.getTrackCount()
             );
+            sendMetadataToArduino(firstNewIndex, playlistModel.getTrackCount());
         }
     }
 }
\ No newline at end of file
@@ -29,6 +29,7 @@ public class DJControllerView {
     private Button addButton;
     private Button removeButton;
     private Button clearButton;
+    private Button upNextButton;
 
     private Button prevButton;
     private Button playButton;
@@ -116,6 +117,7 @@ public class DJControllerView {
         addButton = new Button("Add Tracks");
         removeButton = new Button("Remove");
         clearButton = new Button("Clear All");
+        upNextButton = new Button("Up Next");
 
         prevButton = new Button("⏮");
         playButton = new Button("▶");
@@ -162,11 +164,12 @@ public class DJControllerView {
 
         HBox playlistButtonsBox = new HBox(10);
         playlistButtonsBox.setAlignment(Pos.CENTER_LEFT);
-        playlistButtonsBox.getChildren().addAll(addButton, removeButton, clearButton);
+        playlistButtonsBox.getChildren().addAll(addButton, removeButton, clearButton, upNextButton);
 
         addButton.getStyleClass().add("playlist-button");
         removeButton.getStyleClass().add("playlist-button");
         clearButton.getStyleClass().add("playlist-button");
+        upNextButton.getStyleClass().add("playlist-button");
 
         playlistControls.getChildren().addAll(
                 trackInfoBox,
@@ -373,6 +376,10 @@ public class DJControllerView {
         return clearButton;
     }
 
+    public Button getUpNextButton() {
+        return upNextButton;
+    }
+
     public Button getPrevButton() {
         return prevButton;
     }
@@ -0,0 +1,58 @@
+/**
+ * Arena Allocator Implementation for DJ Controller
+ */
+
+#include "arena.h"
+#include <string.h>
+
+static uint8_t arena[ARENA_SIZE] __attribute__((aligned(ARENA_ALIGN)));
+static size_t arenaTop = 0;
+static size_t arenaHighWater = 0;
+static uint8_t arenaFailures = 0;
+
+void* arena_alloc(size_t size) {
+    size_t bytes = ARENA_BYTES(size);
+
+    if (size == 0 || bytes < size || bytes > ARENA_SIZE - arenaTop) {
+        if (arenaFailures < UINT8_MAX) {
+            arenaFailures++;
+        }
+        return NULL;
+    }
+
+    void* memory = &arena[arenaTop];
+    memset(memory, 0, bytes);
+
+    arenaTop += bytes;
+    if (arenaTop > arenaHighWater) {
+        arenaHighWater = arenaTop;
+    }
+
+    return memory;
+}
+
+void* arena_mark(void) {
+    return &arena[arenaTop];
+}
+
+void arena_release(void* mark) {
+    uint8_t* position = (uint8_t*)mark;
+
+    if (position < arena || position > &arena[arenaTop]) {
+        return;
+    }
+
+    arenaTop = (size_t)(position - arena);
+}
+
+size_t arena_used(void) {
+    return arenaTop;
+}
+
+size_t arena_high_water(void) {
+    return arenaHighWater;
+}
+
+uint8_t arena_failures(void) {
+    return arenaFailures;
+}
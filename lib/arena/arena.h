@@ -0,0 +1,73 @@
+/**
+ * Arena Allocator Library for DJ Controller
+ * 
+ * Provides a fixed-size static arena that replaces malloc for buffers
+ * that live for most of the program, such as the playlist and game
+ * history. The arena is part of .bss, so its size shows up in the
+ * firmware's RAM usage at link time and can never run into the stack.
+ * Allocations are released in reverse order back to a mark.
+ */
+
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Arena size in bytes, override with -DARENA_SIZE=... in build_flags
+#ifndef ARENA_SIZE
+#define ARENA_SIZE 256
+#endif
+
+// AVR needs no alignment; other targets (host tests) align to 8 bytes
+#if defined(__AVR__)
+#define ARENA_ALIGN 1
+#else
+#define ARENA_ALIGN 8
+#endif
+
+// Bytes an allocation of the given size takes from the arena
+#define ARENA_BYTES(size) (((size) + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1))
+
+// Fail the build if a program's arena needs do not fit
+#define ARENA_CHECK(bytes) \
+    _Static_assert((bytes) <= ARENA_SIZE, "arena too small, raise ARENA_SIZE")
+
+/**
+ * Allocate zero-filled memory from the arena
+ * @param size Number of bytes
+ * @return Pointer to the memory or NULL if the arena is full
+ */
+void* arena_alloc(size_t size);
+
+/**
+ * Get a mark for the current top of the arena
+ * @return Mark to pass to arena_release()
+ */
+void* arena_mark(void);
+
+/**
+ * Release a mark or allocation and everything allocated after it
+ * @param mark Mark from arena_mark() or a pointer from arena_alloc()
+ */
+void arena_release(void* mark);
+
+/**
+ * Get the number of bytes in use
+ * @return Bytes allocated
+ */
+size_t arena_used(void);
+
+/**
+ * Get the most bytes ever in use at once
+ * @return High-water mark in bytes
+ */
+size_t arena_high_water(void);
+
+/**
+ * Get the number of allocations that failed because the arena was full
+ * @return Failed allocations
+ */
+uint8_t arena_failures(void);
+
+#endif
@@ -0,0 +1,149 @@
+/**
+ * Beat Tracking Implementation for DJ Controller
+ */
+
+#include "beat.h"
+#include <util/atomic.h>
+
+// Times and the period are kept in 1/256 ms; differences are taken
+// as signed so the 32-bit clock may wrap
+#define Q8(ms) ((uint32_t)(ms) << 8)
+
+// Loop gains as shifts: phase error 1/2, tempo error per beat 1/4
+#define PHASE_GAIN_SHIFT 1
+#define TEMPO_GAIN_SHIFT 2
+
+#define STATE_IDLE 0      // No beat seen
+#define STATE_FIRST 1     // One beat seen, waiting for a second to measure tempo
+#define STATE_LOCKED 2    // Predicting beats
+
+static volatile uint8_t state = STATE_IDLE;
+static uint8_t outliers = 0;
+static uint32_t anchor = 0;               // Time of a beat on the grid (Q8)
+static volatile uint32_t period = 0;      // Beat period (Q8)
+static volatile uint32_t nextBeat = 0;    // Next predicted beat (Q8)
+static volatile uint32_t localClock = 0;  // Local time (Q8)
+static volatile uint8_t holdover = 0;     // Predicted beats left without a message
+static volatile uint8_t beatPending = 0;
+
+void beat_init(void) {
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        state = STATE_IDLE;
+        outliers = 0;
+        period = 0;
+        holdover = 0;
+        beatPending = 0;
+    }
+}
+
+/**
+ * Put the grid on a beat and schedule it as the next one
+ * Call with interrupts disabled
+ * @param beat Time of the beat (Q8)
+ */
+static void beat_lock(uint32_t beat) {
+    anchor = beat;
+    nextBeat = beat;
+    holdover = BEAT_HOLDOVER_BEATS;
+    outliers = 0;
+    state = STATE_LOCKED;
+}
+
+void beat_observe(uint32_t now_ms) {
+    uint32_t now = Q8(now_ms);
+
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        // Keep the tick clock in step with the caller's time base
+        localClock = now;
+
+        if (state == STATE_IDLE || (state == STATE_LOCKED && holdover == 0)) {
+            anchor = now;
+            state = STATE_FIRST;
+        } else if (state == STATE_FIRST) {
+            uint32_t measured = now - anchor;
+
+            if (measured >= Q8(BEAT_MIN_PERIOD_MS) && measured <= Q8(BEAT_MAX_PERIOD_MS)) {
+                period = measured;
+                beat_lock(now);
+            } else {
+                anchor = now;
+            }
+        } else {
+            // Nearest beat on the grid, messages may skip beats
+            uint32_t elapsed = now - anchor;
+            uint32_t beats = (elapsed + period / 2) / period;
+            if (beats == 0) {
+                beats = 1;
+            }
+
+            uint32_t predicted = anchor + beats * period;
+            int32_t error = (int32_t)(now - predicted);
+            int32_t limit = (int32_t)(period / 4);
+
+            if (error > limit || error < -limit) {
+                // Far off the grid: the tempo changed or the link hiccuped
+                if (++outliers >= BEAT_MAX_OUTLIERS) {
+                    anchor = now;
+                    state = STATE_FIRST;
+                }
+            } else {
+                int32_t correction = error / (int32_t)beats;
+                uint32_t adjusted = period + (correction >> TEMPO_GAIN_SHIFT);
+
+                if (adjusted >= Q8(BEAT_MIN_PERIOD_MS) && adjusted <= Q8(BEAT_MAX_PERIOD_MS)) {
+                    period = adjusted;
+                }
+
+                beat_lock(predicted + (error >> PHASE_GAIN_SHIFT));
+
+                // A late message: the local beat already went out
+                while ((int32_t)(now - nextBeat) > 0) {
+                    nextBeat += period;
+                }
+            }
+        }
+    }
+}
+
+void beat_tick(void) {
+    localClock += Q8(1);
+
+    if (state != STATE_LOCKED || holdover == 0) {
+        return;
+    }
+
+    if ((int32_t)(localClock - nextBeat) >= 0) {
+        nextBeat += period;
+        holdover--;
+        beatPending = 1;
+    }
+}
+
+uint8_t beat_poll(void) {
+    uint8_t pending;
+
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        pending = beatPending;
+        beatPending = 0;
+    }
+
+    return pending;
+}
+
+uint8_t beat_locked(void) {
+    return state == STATE_LOCKED && holdover != 0;
+}
+
+uint16_t beat_period_ms(void) {
+    uint32_t current;
+
+    if (!beat_locked()) {
+        return 0;
+    }
+
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        current = period;
+    }
+
+    return (uint16_t)((current + 128) >> 8);
+}
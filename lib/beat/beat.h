@@ -0,0 +1,56 @@
+/**
+ * Beat Tracking Library for DJ Controller
+ * 
+ * Provides a beat phase-locked loop: tempo and phase are estimated from
+ * the beat messages sent by the host, and upcoming beats are predicted
+ * locally from the 1 ms system tick. Effects land on the beat even when a
+ * message arrives late or is dropped, so the host only needs to send an
+ * occasional correction once the loop has locked.
+ */
+
+#ifndef BEAT_H
+#define BEAT_H
+
+#include <avr/io.h>
+
+#define BEAT_MIN_PERIOD_MS 250     // 240 BPM
+#define BEAT_MAX_PERIOD_MS 1500    // 40 BPM
+#define BEAT_HOLDOVER_BEATS 16     // Predicted beats without a message before unlocking
+#define BEAT_MAX_OUTLIERS 3        // Off-beat messages in a row before relocking
+
+/**
+ * Reset the loop to the unlocked state
+ */
+void beat_init(void);
+
+/**
+ * Feed a beat message received from the host
+ * @param now_ms Arrival time in milliseconds (systick_millis())
+ */
+void beat_observe(uint32_t now_ms);
+
+/**
+ * Advance the beat predictor by one millisecond
+ * Call from systick_hook()
+ */
+void beat_tick(void);
+
+/**
+ * Check for a predicted beat since the last call
+ * @return 1 once per predicted beat, 0 otherwise
+ */
+uint8_t beat_poll(void);
+
+/**
+ * Check if the loop is locked and predicting beats
+ * @return 1 if locked, 0 otherwise
+ */
+uint8_t beat_locked(void);
+
+/**
+ * Get the estimated beat period
+ * @return Period in milliseconds, 0 if not locked
+ */
+uint16_t beat_period_ms(void);
+
+#endif
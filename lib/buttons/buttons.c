@@ -6,12 +6,25 @@
 #include "leds.h"
 #include "display.h"
 #include "commands.h"
+#include "playlist.h"
+#include "systick.h"
 
-static uint8_t lastButtonPlay = 1;
-static uint8_t lastButtonNext = 1;
-static uint8_t lastButtonPrev = 1;
+typedef struct {
+    uint8_t pin;
+    uint8_t down;       // Pressed, after debouncing of the release
+    uint8_t handled;    // Press already used by a long press or the chord
+    uint16_t since;     // Time of the press, systick milliseconds
+} ButtonState;
 
-static uint8_t buttonCooldown = 0;
+enum { BUTTON_PLAY, BUTTON_NEXT, BUTTON_PREV, BUTTON_COUNT };
+
+static ButtonState buttons[BUTTON_COUNT] = {
+    { BUTTON_PLAY_PIN, 0, 0, 0 },
+    { BUTTON_NEXT_PIN, 0, 0, 0 },
+    { BUTTON_PREV_PIN, 0, 0, 0 },
+};
+
+static uint8_t selectedCue = 0;
 
 // External variables from commands module
 extern uint8_t isPlaying;
@@ -19,23 +32,39 @@ extern uint8_t isPlaying;
 void buttons_init(void) {
     DDRC &= ~((1 << BUTTON_PLAY_PIN) | (1 << BUTTON_NEXT_PIN) | (1 << BUTTON_PREV_PIN));
     PORTC |= (1 << BUTTON_PLAY_PIN) | (1 << BUTTON_NEXT_PIN) | (1 << BUTTON_PREV_PIN);
-    
-    buttonCooldown = 0;
+
+    for (uint8_t i = 0; i < BUTTON_COUNT; i++) {
+        buttons[i].down = 0;
+    }
+    selectedCue = 0;
 }
 
 uint8_t read_button(uint8_t pin) {
     return (PINC & (1 << pin)) ? 1 : 0;
 }
 
-void buttons_check(void) {
-    if (buttonCooldown > 0) {
-        buttonCooldown--;
-        return;
-    }
-    
-    uint8_t buttonPlay = read_button(BUTTON_PLAY_PIN);
-    
-    if (buttonPlay == 0 && lastButtonPlay == 1) {
+/**
+ * Show a cue number on the display ("CUE1")
+ * @param prefix Three-character prefix
+ * @param cue Cue number (0-based)
+ */
+static void show_cue(const char* prefix, uint8_t cue) {
+    char text[5];
+    text[0] = prefix[0];
+    text[1] = prefix[1];
+    text[2] = prefix[2];
+    text[3] = '1' + cue;
+    text[4] = '\0';
+    display_message(text, 300);
+}
+
+/**
+ * Action of a short press, on release
+ * @param button Button index
+ */
+static void button_short_press(uint8_t button) {
+    switch (button) {
+    case BUTTON_PLAY:
         if (isPlaying) {
             send_command(CMD_REQUEST_PAUSE);
             display_message("RPAU", 100);
@@ -43,33 +72,85 @@ void buttons_check(void) {
             send_command(CMD_REQUEST_PLAY);
             display_message("RPLY", 100);
         }
-        
         led_toggle(LED_PLAY_PIN);
-        buttonCooldown = 50;
-    }
-    lastButtonPlay = buttonPlay;
+        break;
 
-    uint8_t buttonNext = read_button(BUTTON_NEXT_PIN);
-    
-    if (buttonNext == 0 && lastButtonNext == 1) {
-        send_command(CMD_REQUEST_NEXT);
+    case BUTTON_NEXT:
+        send_track_request(1);
         display_message("RNXT", 100);
-        
         flash_led_briefly(LED_TRACK_PIN, 100);
-        
-        buttonCooldown = 50;
-    }
-    lastButtonNext = buttonNext;
-    
-    uint8_t buttonPrev = read_button(BUTTON_PREV_PIN);
-    
-    if (buttonPrev == 0 && lastButtonPrev == 1) {
-        send_command(CMD_REQUEST_PREV);
+        break;
+
+    case BUTTON_PREV:
+        send_track_request(0);
         display_message("RPRV", 100);
-  
         flash_led_briefly(LED_TRACK_PIN, 100);
-        
-        buttonCooldown = 50;
+        break;
     }
-    lastButtonPrev = buttonPrev;
-}
\ No newline at end of file
+}
+
+/**
+ * Action of a long press, once BUTTON_LONG_PRESS_MS is reached
+ * PLAY sets the selected cue, NEXT jumps to it, PREV selects the next cue
+ * @param button Button index
+ */
+static void button_long_press(uint8_t button) {
+    switch (button) {
+    case BUTTON_PLAY:
+        send_cue_set_request(selectedCue);
+        show_cue("SET", selectedCue);
+        break;
+
+    case BUTTON_NEXT:
+        if (send_cue_jump(selectedCue)) {
+            show_cue("CUE", selectedCue);
+            flash_led_briefly(LED_SEEK_PIN, 100);
+        } else {
+            show_cue("NO ", selectedCue);
+        }
+        break;
+
+    case BUTTON_PREV:
+        selectedCue = (selectedCue + 1) % PLAYLIST_CUES;
+        show_cue("CUE", selectedCue);
+        break;
+    }
+}
+
+void buttons_check(void) {
+    uint16_t now = (uint16_t)systick_millis();
+
+    for (uint8_t i = 0; i < BUTTON_COUNT; i++) {
+        ButtonState* button = &buttons[i];
+        uint8_t pressed = read_button(button->pin) == 0;
+
+        if (pressed && !button->down) {
+            button->down = 1;
+            button->handled = 0;
+            button->since = now;
+
+            // Pressing NEXT or PREV while the other one is held toggles shuffle
+            if (i != BUTTON_PLAY) {
+                ButtonState* other = &buttons[(i == BUTTON_NEXT) ? BUTTON_PREV : BUTTON_NEXT];
+
+                if (other->down) {
+                    display_message(commands_toggle_shuffle() ? "SHUF" : "ORDR", 300);
+                    button->handled = 1;
+                    other->handled = 1;
+                }
+            }
+        } else if (pressed) {
+            if (!button->handled && (uint16_t)(now - button->since) >= BUTTON_LONG_PRESS_MS) {
+                button->handled = 1;
+                button_long_press(i);
+            }
+        } else if (button->down) {
+            button->down = 0;
+
+            // Contact bounce gives presses shorter than the debounce time
+            if (!button->handled && (uint16_t)(now - button->since) >= BUTTON_BOUNCE_MS) {
+                button_short_press(i);
+            }
+        }
+    }
+}
@@ -14,6 +14,9 @@
 #define BUTTON_NEXT_PIN 2  // PC2
 #define BUTTON_PREV_PIN 3  // PC3
 
+#define BUTTON_BOUNCE_MS 30       // Shorter presses are contact bounce
+#define BUTTON_LONG_PRESS_MS 700  // Hold time for a long press
+
 /**
  * Initialize the button pins as inputs with pull-ups
  */
@@ -28,6 +31,10 @@ uint8_t read_button(uint8_t pin);
 
 /**
  * Process all button inputs and trigger necessary actions
+ * Short presses act on release: play/pause, next and previous track.
+ * Long presses work with cue points: PREV selects the next cue, PLAY
+ * sets it at the playing position and NEXT jumps to it. Pressing NEXT
+ * and PREV together toggles shuffle. Needs the systick timer
  */
 void buttons_check(void);
 
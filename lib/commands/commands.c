@@ -7,6 +7,10 @@
 #include "display.h"
 #include "leds.h"
 #include "playlist.h"
+#include "potentiometer.h"
+#include "beat.h"
+#include "systick.h"
+#include "storage.h"
 #include <stdlib.h>
 #include <string.h>
 #include <util/delay.h>
@@ -24,57 +28,130 @@ void commands_init(void)
     totalTracks = 1;
 }
 
-void commands_set_playlist(Playlist **playlist_ptr)
+/**
+ * Pack the track counters and play state into one stored value
+ * @return Current track, total tracks and play state, one byte each
+ */
+static uint32_t pack_state(void)
 {
-    if (playlist_ptr != NULL)
-    {
-        active_playlist = *playlist_ptr;
-    }
+    return (uint32_t)currentTrack | ((uint32_t)totalTracks << 8) | ((uint32_t)isPlaying << 16);
 }
 
-void reset_track_counters(void)
+void commands_restore_state(void)
 {
-    currentTrack = 1;
-    totalTracks = 1;
+    uint32_t value;
 
-    if (active_playlist != NULL)
+    if (storage_get(STORAGE_KEY_PLAYLIST, &value))
+    {
+        uint8_t current = value & 0xFF;
+        uint8_t total = (value >> 8) & 0xFF;
+
+        if (total >= 1 && total <= 99 && current >= 1 && current <= total)
+        {
+            currentTrack = current;
+            totalTracks = total;
+            isPlaying = (value >> 16) & 1;
+        }
+    }
+
+    if (storage_get(STORAGE_KEY_LED_BRIGHTNESS, &value))
+    {
+        led_set_max_brightness(value);
+    }
+
+    if (isPlaying)
     {
-        active_playlist->count = 0;
-        active_playlist->current_index = 0;
+        led_on(LED_PLAY_PIN);
     }
+
+    transmit_byte(CMD_REPORT_RESTORED);
+    transmit_byte(currentTrack);
+    transmit_byte(totalTracks);
+    transmit_byte(isPlaying);
 }
 
-void update_playlist_tracks(void)
+void commands_save_state(void)
+{
+    storage_set(STORAGE_KEY_PLAYLIST, pack_state());
+}
+
+/**
+ * Bring the playlist length in line with totalTracks
+ * Only the tracks added or removed at the end are touched
+ */
+static void sync_playlist_length(void)
 {
     if (active_playlist == NULL)
     {
         return;
     }
 
-    active_playlist->count = 0;
-
-    for (uint8_t i = 1; i <= totalTracks; i++)
+    while (active_playlist->count < totalTracks)
     {
-        Track new_track;
-        sprintf(new_track.name, "TR%02d", i);
-        new_track.number = i;
-        new_track.duration_sec = 180;
-        new_track.isPlaying = (isPlaying && (i == currentTrack));
-
-        if (active_playlist->count < active_playlist->capacity)
+        if (!playlist_append_track(active_playlist, PLAYLIST_DEFAULT_DURATION))
         {
-            memcpy(&(active_playlist->tracks[active_playlist->count]), &new_track, sizeof(Track));
-            active_playlist->count++;
+            break;
         }
     }
 
-    if (currentTrack <= totalTracks && currentTrack > 0)
+    while (active_playlist->count > totalTracks)
+    {
+        playlist_remove_last_track(active_playlist);
+    }
+}
+
+/**
+ * Point the playlist at currentTrack
+ */
+static void sync_playlist_current(void)
+{
+    if (active_playlist != NULL && currentTrack > 0)
     {
-        active_playlist->current_index = currentTrack - 1;
         playlist_set_current_track(active_playlist, currentTrack - 1);
     }
 }
 
+/**
+ * Show a track name on the display
+ * With a playlist the name scrolls from the main loop, without blocking
+ * @param number Track number
+ * @param display_time Time to show it in milliseconds
+ */
+static void show_track(uint8_t number, uint16_t display_time)
+{
+    if (active_playlist != NULL)
+    {
+        active_playlist->display_needs_update = 1;
+        return;
+    }
+
+    char name[5];
+    playlist_format_name(number, name);
+    display_message(name, display_time);
+}
+
+void commands_set_playlist(Playlist **playlist_ptr)
+{
+    if (playlist_ptr != NULL)
+    {
+        active_playlist = *playlist_ptr;
+        sync_playlist_length();
+        sync_playlist_current();
+    }
+}
+
+void reset_track_counters(void)
+{
+    currentTrack = 1;
+    totalTracks = 1;
+
+    if (active_playlist != NULL)
+    {
+        playlist_clear(active_playlist);
+        sync_playlist_length();
+    }
+}
+
 void send_command(uint8_t cmd)
 {
     transmit_byte(cmd);
@@ -85,6 +162,78 @@ void send_command(uint8_t cmd)
     display_message(cmdStr, 50);
 }
 
+void send_controls_report(uint8_t changed)
+{
+    transmit_byte(CMD_REQUEST_CONTROLS);
+    transmit_byte(changed);
+
+    for (uint8_t slot = 0; slot < ADC_SCAN_MAX_CHANNELS; slot++)
+    {
+        if (changed & (1 << slot))
+        {
+            transmit_byte(adc_scan_value(slot) >> 2);
+        }
+    }
+}
+
+void send_seek_position(uint16_t permille)
+{
+    transmit_byte(CMD_REQUEST_SEEK_ABS);
+    transmit_byte(permille >> 8);
+    transmit_byte(permille & 0xFF);
+}
+
+void send_cue_set_request(uint8_t cue)
+{
+    transmit_byte(CMD_REQUEST_SET_CUE);
+    transmit_byte(cue);
+}
+
+uint8_t send_cue_jump(uint8_t cue)
+{
+    uint16_t seconds;
+
+    if (!playlist_get_cue(active_playlist, cue, &seconds))
+    {
+        return 0;
+    }
+
+    transmit_byte(CMD_REQUEST_SEEK_SEC);
+    transmit_byte(seconds >> 8);
+    transmit_byte(seconds & 0xFF);
+
+    return 1;
+}
+
+void send_track_request(uint8_t next)
+{
+    if (!next || active_playlist == NULL || !active_playlist->shuffle)
+    {
+        send_command(next ? CMD_REQUEST_NEXT : CMD_REQUEST_PREV);
+        return;
+    }
+
+    if (playlist_next_track(active_playlist))
+    {
+        // Java takes the track as is, so the track counters stay in sync
+        currentTrack = active_playlist->current_index + 1;
+        transmit_byte(CMD_REQUEST_JUMP);
+        transmit_byte(active_playlist->current_index);
+    }
+}
+
+uint8_t commands_toggle_shuffle(void)
+{
+    if (active_playlist == NULL)
+    {
+        return 0;
+    }
+
+    playlist_set_shuffle(active_playlist, !active_playlist->shuffle);
+
+    return active_playlist->shuffle;
+}
+
 void process_serial(void)
 {
     if (is_data_available())
@@ -113,13 +262,16 @@ void process_serial(void)
             
             led_off(LED_PLAY_PIN);
             display_string("PAUS");
+
+            // The host stops sending beats while paused
+            beat_init();
             break;
 
         case CMD_TRACK_COUNT_INC:
             {
                 totalTracks++;
                 if (totalTracks > 99) totalTracks = 99;
-                update_playlist_tracks();
+                sync_playlist_length();
                 
                 char total_msg[5];
                 sprintf(total_msg, "T%02d", totalTracks);
@@ -136,7 +288,8 @@ void process_serial(void)
                 {
                     currentTrack = totalTracks;
                 }
-                update_playlist_tracks();
+                sync_playlist_length();
+                sync_playlist_current();
             }
 
             char total_dec_msg[5];
@@ -155,11 +308,9 @@ void process_serial(void)
             {
                 currentTrack = 1;
             }
-            update_playlist_tracks();
+            sync_playlist_current();
 
-            char curr_inc_msg[5];
-            sprintf(curr_inc_msg, "TR%02d", currentTrack);
-            display_message(curr_inc_msg, 300);
+            show_track(currentTrack, 300);
         }
         break;
 
@@ -173,11 +324,9 @@ void process_serial(void)
             {
                 currentTrack = totalTracks;
             }
-            update_playlist_tracks();
+            sync_playlist_current();
 
-            char curr_dec_msg[5];
-            sprintf(curr_dec_msg, "TR%02d", currentTrack);
-            display_message(curr_dec_msg, 300);
+            show_track(currentTrack, 300);
         }
         break;
 
@@ -191,11 +340,9 @@ void process_serial(void)
             {
                 currentTrack = 1;
             }
-            update_playlist_tracks();
+            sync_playlist_current();
 
-            char next_msg[5];
-            sprintf(next_msg, "TR%02d", currentTrack);
-            display_message(next_msg, 300);
+            show_track(currentTrack, 300);
 
             _delay_ms(100);
             send_command(CMD_REQUEST_STATUS);
@@ -204,32 +351,121 @@ void process_serial(void)
 
         case CMD_PREV_TRACK:
         {
-            if (currentTrack > 1)
+            // Back through the play history, the same way Java went
+            if (active_playlist != NULL && playlist_prev_track(active_playlist))
             {
-                currentTrack--;
+                currentTrack = active_playlist->current_index + 1;
             }
             else
             {
-                currentTrack = totalTracks;
+                if (currentTrack > 1)
+                {
+                    currentTrack--;
+                }
+                else
+                {
+                    currentTrack = totalTracks;
+                }
+                sync_playlist_current();
             }
-            update_playlist_tracks();
 
-            char prev_msg[5];
-            sprintf(prev_msg, "TR%02d", currentTrack);
-            display_message(prev_msg, 300);
+            show_track(currentTrack, 300);
 
             _delay_ms(100);
             send_command(CMD_REQUEST_STATUS);
         }
         break;
 
-        case CMD_BEAT_DETECTED:
-            led_on(LED_STATUS_PIN);
-            for (uint8_t i = 0; i < 50; i++)
+        case CMD_JUMP_TRACK:
+        {
+            uint8_t index = receive_byte();
+
+            if (index < totalTracks)
             {
-                display_update(1);
+                currentTrack = index + 1;
+                sync_playlist_current();
+                show_track(currentTrack, 300);
             }
-            led_off(LED_STATUS_PIN);
+        }
+        break;
+
+        case CMD_ENQUEUE_TRACK:
+        {
+            uint8_t index = receive_byte();
+
+            if (active_playlist != NULL && playlist_enqueue(active_playlist, index))
+            {
+                char text[5] = "UP00";
+                text[2] = '0' + ((index + 1) / 10) % 10;
+                text[3] = '0' + (index + 1) % 10;
+                display_message(text, 300);
+            }
+        }
+        break;
+
+        case CMD_TRACK_METADATA:
+        {
+            uint8_t index = receive_byte();
+            uint16_t duration = (uint16_t)receive_byte() << 8;
+            duration |= receive_byte();
+            uint8_t length = receive_byte();
+            char name[PLAYLIST_NAME_LENGTH + 1];
+
+            // Characters past PLAYLIST_NAME_LENGTH are read and dropped
+            for (uint8_t i = 0; i < length; i++)
+            {
+                char c = receive_byte();
+
+                if (i < PLAYLIST_NAME_LENGTH)
+                {
+                    name[i] = c;
+                }
+            }
+            name[length < PLAYLIST_NAME_LENGTH ? length : PLAYLIST_NAME_LENGTH] = '\0';
+
+            if (active_playlist != NULL)
+            {
+                playlist_set_duration(active_playlist, index, duration);
+
+                // Only the current track's name is held, others would replace it
+                if (index == active_playlist->current_index)
+                {
+                    playlist_set_name(active_playlist, index, name);
+                }
+            }
+        }
+        break;
+
+        case CMD_CUE_POINTS:
+        {
+            uint8_t index = receive_byte();
+
+            for (uint8_t cue = 0; cue < PLAYLIST_CUES; cue++)
+            {
+                uint16_t seconds = (uint16_t)receive_byte() << 8;
+                seconds |= receive_byte();
+                playlist_set_cue(active_playlist, index, cue, seconds);
+            }
+        }
+        break;
+
+        case CMD_SET_BRIGHTNESS:
+        {
+            uint8_t level = receive_byte();
+
+            led_set_max_brightness(level);
+            storage_set(STORAGE_KEY_LED_BRIGHTNESS, led_get_max_brightness());
+        }
+        break;
+
+        case CMD_CLEAR_HISTORY:
+            playlist_clear_history(active_playlist);
+            playlist_clear_queue(active_playlist);
+            break;
+
+        case CMD_BEAT_DETECTED:
+            // The beat LED follows the loop's predicted beats
+            beat_observe(systick_millis());
             break;
 
         case CMD_SEEK_FORWARD:
@@ -242,9 +478,7 @@ void process_serial(void)
 
         case CMD_STATUS_REQUEST:
         {
-            char status_msg[5];
-            sprintf(status_msg, "TR%02d", currentTrack);
-            display_message(status_msg, 200);
+            show_track(currentTrack, 200);
         }
         break;
 
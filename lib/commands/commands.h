@@ -24,6 +24,12 @@ typedef struct Playlist Playlist;
 #define CMD_CURRENT_TRACK_INC 'C'
 #define CMD_CURRENT_TRACK_DEC 'V'
 #define CMD_BEAT_DETECTED 'b'
+#define CMD_JUMP_TRACK 'J'        // Followed by the track index (0-based)
+#define CMD_ENQUEUE_TRACK 'U'     // Followed by the track index (0-based)
+#define CMD_CLEAR_HISTORY 'H'     // Forget the play history and the up-next queue
+#define CMD_SET_BRIGHTNESS 'L'    // Followed by the LED brightness ceiling (0-31)
+#define CMD_TRACK_METADATA 'M'    // Followed by the track index, duration (seconds, high byte first), name length and name (kept for the current track only)
+#define CMD_CUE_POINTS 'E'        // Followed by the track index and 4 cue points (seconds, high byte first, 0xFFFF = none)
 
 #define CMD_REQUEST_PLAY 'P'
 #define CMD_REQUEST_PAUSE 'S'
@@ -32,6 +38,12 @@ typedef struct Playlist Playlist;
 #define CMD_REQUEST_SEEK_FWD 'F'
 #define CMD_REQUEST_SEEK_BWD 'R'
 #define CMD_REQUEST_STATUS 'Q'
+#define CMD_REQUEST_CONTROLS 'K'  // Followed by a slot mask and one byte per changed slot
+#define CMD_REQUEST_SEEK_ABS 'A'  // Followed by the position in permille (high byte, low byte)
+#define CMD_REPORT_RESTORED 'Y'   // Followed by current track, total tracks, play state
+#define CMD_REQUEST_SET_CUE 'c'   // Followed by the cue number, set at the current position
+#define CMD_REQUEST_SEEK_SEC 'G'  // Followed by the position in seconds (high byte, low byte)
+#define CMD_REQUEST_JUMP 'J'      // Followed by the track index (0-based), sent in shuffle mode
 
 extern uint8_t isPlaying;
 extern uint8_t currentTrack;
@@ -47,6 +59,52 @@ extern uint8_t totalTracks;
  */
 void send_command(uint8_t cmd);
 
+/**
+ * Send one aggregated report of changed control pots to Java
+ * Frame: 'K', slot mask, then the 8-bit value of every slot in the mask
+ * @param changed Bitmask of changed control slots
+ */
+void send_controls_report(uint8_t changed);
+
+/**
+ * Request an absolute seek in the current track
+ * Frame: 'A', permille high byte, permille low byte
+ * @param permille Track position (0-1000)
+ */
+void send_seek_position(uint16_t permille);
+
+/**
+ * Ask Java to set a cue point of the current track at the playing position
+ * Java answers with the track's cue points ('E')
+ * Frame: 'c', cue number
+ * @param cue Cue number (0 to PLAYLIST_CUES - 1)
+ */
+void send_cue_set_request(uint8_t cue);
+
+/**
+ * Jump to a cue point of the current track
+ * The position is sent as an absolute seek, so Java can seek right away
+ * Frame: 'G', seconds high byte, seconds low byte
+ * @param cue Cue number (0 to PLAYLIST_CUES - 1)
+ * @return 1 if the cue point is set and the seek was sent, 0 otherwise
+ */
+uint8_t send_cue_jump(uint8_t cue);
+
+/**
+ * Ask Java for the next or previous track
+ * In shuffle mode the playlist picks the next track and a jump is sent
+ * instead (frame: 'J', track index). Java keeps the play history, so
+ * PREV is always a request
+ * @param next 1 for the next track, 0 for the previous one
+ */
+void send_track_request(uint8_t next);
+
+/**
+ * Turn shuffle mode of the active playlist on or off
+ * @return 1 if shuffle is now on, 0 otherwise
+ */
+uint8_t commands_toggle_shuffle(void);
+
 /**
  * Process serial data received from Java
  */
@@ -56,6 +114,20 @@ void process_serial(void);
  */
 void commands_init(void);
 
+/**
+ * Restore the track counters, play state and LED brightness from EEPROM
+ * and report them to Java, so it only has to send what changed
+ * Frame: 'Y', current track, total tracks, play state
+ * Call after storage_init() and before commands_set_playlist()
+ */
+void commands_restore_state(void);
+
+/**
+ * Store the track counters and play state if they changed
+ * Call from the main loop together with storage_poll()
+ */
+void commands_save_state(void);
+
 /**
  * Set the active playlist (by-reference parameter example)
  * @param playlist_ptr Pointer to a playlist pointer
@@ -0,0 +1,80 @@
+/**
+ * Fixed-Point Arithmetic Implementation
+ */
+
+#include "fixedpoint.h"
+#include <stdlib.h>
+
+uint8_t ratio_init(Ratio* ratio, uint16_t num, uint16_t den, uint16_t max_x) {
+    if (den == 0) {
+        return 0;
+    }
+
+    // The rounding error of the multiplier is below den, so the result stays
+    // exact as long as max_x * (den - 1) < 2^shift
+    uint32_t error_bound = (uint32_t)max_x * (den - 1);
+    uint8_t shift = 0;
+
+    while (shift < 31 && ((uint32_t)1 << shift) <= error_bound) {
+        shift++;
+    }
+
+    uint32_t scaled = (uint32_t)num << shift;
+    if (shift >= 16 && num >= ((uint32_t)1 << (32 - shift))) {
+        return 0;
+    }
+
+    uint32_t multiplier = scaled / den;
+    if (multiplier * den != scaled) {
+        multiplier++;
+    }
+
+    // x * multiplier must not overflow 32 bits
+    if (max_x > 0 && multiplier > UINT32_MAX / max_x) {
+        return 0;
+    }
+
+    ratio->multiplier = multiplier;
+    ratio->shift = shift;
+
+    return 1;
+}
+
+int32_t map_value(int32_t x, int32_t in_min, int32_t in_max, int32_t out_min, int32_t out_max) {
+    return (x - in_min) * (out_max - out_min) / (in_max - in_min) + out_min;
+}
+
+uint8_t map_scale_init(MapScale* scale, int16_t in_min, int16_t in_max, int16_t out_min, int16_t out_max) {
+    int16_t in_span = in_max - in_min;
+    int16_t out_span = out_max - out_min;
+
+    if (in_span == 0 || abs(in_span) > 1023 || abs(out_span) > 4095) {
+        return 0;
+    }
+
+    scale->in_min = in_min;
+    scale->in_max = in_max;
+    scale->out_min = out_min;
+    scale->negative = (out_span < 0);
+
+    // C division truncates towards zero, so the magnitude is floor(|t| * |out| / |in|)
+    return ratio_init(&scale->ratio, abs(out_span), abs(in_span), abs(in_span));
+}
+
+int16_t map_value_scaled(const MapScale* scale, int16_t x) {
+    uint16_t t;
+
+    if (scale->in_max > scale->in_min) {
+        if (x < scale->in_min) x = scale->in_min;
+        if (x > scale->in_max) x = scale->in_max;
+        t = x - scale->in_min;
+    } else {
+        if (x > scale->in_min) x = scale->in_min;
+        if (x < scale->in_max) x = scale->in_max;
+        t = scale->in_min - x;
+    }
+
+    uint16_t q = ratio_apply(&scale->ratio, t);
+
+    return scale->negative ? scale->out_min - (int16_t)q : scale->out_min + (int16_t)q;
+}
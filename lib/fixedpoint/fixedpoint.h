@@ -0,0 +1,114 @@
+/**
+ * Fixed-Point Arithmetic Library
+ * 
+ * Provides Q8.8 helpers, exact reciprocal multiplication and range mapping
+ * so hot paths avoid soft-float and 32-bit division on the AVR
+ */
+
+#ifndef FIXEDPOINT_H
+#define FIXEDPOINT_H
+
+#include <stdint.h>
+
+// Q8.8 signed fixed-point value
+typedef int16_t fix8_t;
+
+#define FIX8_ONE 256
+#define FIX8_FROM_INT(x) ((fix8_t)((x) * FIX8_ONE))
+#define FIX8_TO_INT(x) ((int16_t)((x) >> 8))
+
+/**
+ * Precomputed ratio num/den for exact floor(x * num / den) by multiply and shift
+ */
+typedef struct {
+    uint32_t multiplier;  // ceil(num * 2^shift / den)
+    uint8_t shift;
+} Ratio;
+
+/**
+ * Precomputed mapping from one range to another
+ */
+typedef struct {
+    int16_t in_min;
+    int16_t in_max;
+    int16_t out_min;
+    uint8_t negative;  // Output range runs downwards
+    Ratio ratio;
+} MapScale;
+
+/**
+ * Multiply two Q8.8 values
+ * @param a First factor
+ * @param b Second factor
+ * @return a * b in Q8.8 (truncated)
+ */
+static inline fix8_t fix8_mul(fix8_t a, fix8_t b) {
+    return (fix8_t)(((int32_t)a * b) >> 8);
+}
+
+/**
+ * Prepare a ratio for exact scaling
+ * Uses a 32-bit division once; ratio_apply() only multiplies and shifts
+ * @param ratio Pointer to the ratio to fill in
+ * @param num Numerator
+ * @param den Denominator (must not be 0)
+ * @param max_x Largest x that will be passed to ratio_apply()
+ * @return 1 if the result is exact for every x <= max_x, 0 if the ranges are too large
+ */
+uint8_t ratio_init(Ratio* ratio, uint16_t num, uint16_t den, uint16_t max_x);
+
+/**
+ * Scale a value by a precomputed ratio
+ * @param ratio Pointer to a ratio set up with ratio_init()
+ * @param x Value to scale (0 to max_x)
+ * @return floor(x * num / den)
+ */
+static inline uint16_t ratio_apply(const Ratio* ratio, uint16_t x) {
+    return (uint16_t)(((uint32_t)x * ratio->multiplier) >> ratio->shift);
+}
+
+/**
+ * Prepare a reciprocal for exact division by a constant
+ * @param ratio Pointer to the ratio to fill in
+ * @param divisor Divisor (must not be 0)
+ * @param max_dividend Largest dividend that will be divided
+ * @return 1 if exact for every dividend <= max_dividend, 0 otherwise
+ */
+static inline uint8_t reciprocal_init(Ratio* ratio, uint16_t divisor, uint16_t max_dividend) {
+    return ratio_init(ratio, 1, divisor, max_dividend);
+}
+
+/**
+ * Map a value from one range to another
+ * @param x The value to map
+ * @param in_min The minimum of the input range
+ * @param in_max The maximum of the input range
+ * @param out_min The minimum of the output range
+ * @param out_max The maximum of the output range
+ * @return The mapped value
+ */
+int32_t map_value(int32_t x, int32_t in_min, int32_t in_max, int32_t out_min, int32_t out_max);
+
+/**
+ * Precompute a mapping for map_value_scaled()
+ * Input span up to 1023 counts, output span up to 4095
+ * @param scale Pointer to the mapping to fill in
+ * @param in_min The minimum of the input range
+ * @param in_max The maximum of the input range
+ * @param out_min The minimum of the output range
+ * @param out_max The maximum of the output range
+ * @return 1 if successful, 0 if the ranges are empty or too large
+ */
+uint8_t map_scale_init(MapScale* scale, int16_t in_min, int16_t in_max, int16_t out_min, int16_t out_max);
+
+/**
+ * Map a value with a precomputed mapping (no division)
+ * Gives the same result as map_value() for x inside the input range;
+ * x outside the input range is clamped to it
+ * @param scale Pointer to a mapping set up with map_scale_init()
+ * @param x The value to map
+ * @return The mapped value
+ */
+int16_t map_value_scaled(const MapScale* scale, int16_t x);
+
+#endif
@@ -3,6 +3,178 @@
  */
 
 #include "leds.h"
+#include <avr/interrupt.h>
+#include <avr/pgmspace.h>
+#include <util/atomic.h>
+
+#define LED_MASK ((1 << LED_PLAY_PIN) | (1 << LED_TRACK_PIN) | \
+                  (1 << LED_SEEK_PIN) | (1 << LED_STATUS_PIN))
+
+// Timer0 interrupts per millisecond (8 kHz)
+#define PWM_TICKS_PER_MS 8
+
+// CPU cycles per Timer0 count with prescaler 8
+#define CYCLES_PER_COUNT 8
+
+// Brightness level to PWM duty, gamma 2.2
+static const uint8_t GAMMA[LED_LEVEL_MAX + 1] PROGMEM = {
+     0,  1,  1,  1,  1,  1,  2,  2,  3,  4,  5,  7,  8,  9, 11, 13,
+    15, 17, 19, 22, 24, 27, 30, 33, 36, 40, 43, 47, 51, 55, 60, 64
+};
+
+typedef struct {
+    uint16_t level;    // Current brightness, Q8.8
+    uint16_t step;     // Change per millisecond, Q8.8, 0 when idle
+    uint8_t target;    // Target brightness
+    uint8_t breathe;   // 1 to bounce between 0 and LED_LEVEL_MAX
+} LedFade;
+
+typedef struct {
+    uint8_t pattern;     // Bits shown LSB first, 1 = on
+    uint8_t length;      // Bits per repeat, 0 when idle
+    uint8_t bit;         // Bit currently shown
+    uint8_t repeat;      // Repeats left, 0 = until cancelled
+    uint16_t step_ms;    // Time per bit
+    uint16_t countdown;  // Milliseconds left for the current bit
+} LedEffect;
+
+static volatile uint8_t ledDuty[LED_COUNT];
+static volatile uint8_t pwmMask = 0;         // LEDs driven by the PWM
+static volatile LedFade fades[LED_COUNT];
+static volatile LedEffect effects[LED_COUNT];
+static volatile uint8_t maxLevel = LED_LEVEL_MAX;
+static uint8_t pwmSlot = 0;
+static uint8_t msDivider = 0;
+static volatile uint16_t isrCyclesMax = 0;
+
+/**
+ * Map an LED pin to its index
+ * @param pin The pin number of the LED
+ * @return Index 0 to LED_COUNT - 1, or LED_COUNT for other pins
+ */
+static uint8_t led_index(uint8_t pin) {
+    if (pin < LED_PLAY_PIN || pin > LED_STATUS_PIN) {
+        return LED_COUNT;
+    }
+
+    return pin - LED_PLAY_PIN;
+}
+
+/**
+ * Map a brightness to a PWM duty, scaled to the brightness ceiling
+ * @param level Brightness, Q8.8
+ * @return Duty in PWM steps
+ */
+static uint8_t led_duty(uint16_t level) {
+    uint8_t scaled = ((level >> 8) * (maxLevel + 1)) / (LED_LEVEL_MAX + 1);
+
+    return pgm_read_byte(&GAMMA[scaled]);
+}
+
+/**
+ * Advance all fades by one millisecond
+ * Runs from the Timer0 interrupt
+ */
+static void leds_fade_tick(void) {
+    for (uint8_t i = 0; i < LED_COUNT; i++) {
+        volatile LedFade* fade = &fades[i];
+
+        if (fade->step == 0) {
+            continue;
+        }
+
+        uint16_t target = (uint16_t)fade->target << 8;
+
+        if (fade->level < target) {
+            fade->level = (target - fade->level > fade->step) ? fade->level + fade->step : target;
+        } else {
+            fade->level = (fade->level - target > fade->step) ? fade->level - fade->step : target;
+        }
+
+        if (fade->level == target) {
+            if (fade->breathe) {
+                fade->target = fade->target ? 0 : LED_LEVEL_MAX;
+            } else {
+                fade->step = 0;
+            }
+        }
+
+        ledDuty[i] = led_duty(fade->level);
+    }
+}
+
+/**
+ * Drive an effect LED directly (common anode - LOW = on)
+ * @param index LED index
+ * @param on 1 to switch on, 0 to switch off
+ */
+static void led_write(uint8_t index, uint8_t on) {
+    if (on) {
+        PORTB &= ~(1 << (LED_PLAY_PIN + index));
+    } else {
+        PORTB |= (1 << (LED_PLAY_PIN + index));
+    }
+}
+
+/**
+ * Advance all blink effects by one millisecond
+ * Runs from the Timer0 interrupt
+ */
+static void leds_effect_tick(void) {
+    for (uint8_t i = 0; i < LED_COUNT; i++) {
+        volatile LedEffect* effect = &effects[i];
+
+        if (effect->length == 0 || --effect->countdown != 0) {
+            continue;
+        }
+
+        effect->countdown = effect->step_ms;
+
+        if (++effect->bit == effect->length) {
+            effect->bit = 0;
+
+            if (effect->repeat && --effect->repeat == 0) {
+                effect->length = 0;
+                led_write(i, 0);
+                continue;
+            }
+        }
+
+        led_write(i, (effect->pattern >> effect->bit) & 1);
+    }
+}
+
+ISR(TIMER0_COMPA_vect) {
+    uint8_t off = 0;
+
+    pwmSlot = (pwmSlot + 1) & (LED_PWM_STEPS - 1);
+
+    // Common anode, a pin goes high (off) once the slot passes its duty
+    for (uint8_t i = 0; i < LED_COUNT; i++) {
+        if (pwmSlot >= ledDuty[i]) {
+            off |= (1 << (LED_PLAY_PIN + i));
+        }
+    }
+
+    PORTB = (PORTB & ~pwmMask) | (off & pwmMask);
+
+    if (++msDivider == PWM_TICKS_PER_MS) {
+        msDivider = 0;
+        leds_fade_tick();
+        leds_effect_tick();
+    }
+
+    // Cycles since the compare match that triggered us, rounded up to whole
+    // timer counts. A pending match means TCNT0 has been cleared again and
+    // the real count is unknown
+    uint16_t cycles = (uint16_t)(TCNT0 + 1) * CYCLES_PER_COUNT;
+    if (TIFR0 & (1 << OCF0A)) {
+        cycles = LED_ISR_OVERRUN;
+    }
+    if (cycles > isrCyclesMax) {
+        isrCyclesMax = cycles;
+    }
+}
 
 void leds_init(void) {
     // Set LED pins as outputs
@@ -12,18 +184,204 @@ void leds_init(void) {
     // LEDs off initially (common anode - HIGH = off)
     PORTB |= (1 << LED_PLAY_PIN) | (1 << LED_TRACK_PIN) | 
              (1 << LED_SEEK_PIN) | (1 << LED_STATUS_PIN);
+
+    isrCyclesMax = 0;
+
+    // LED timer: CTC mode, prescaler 8: 16MHz / 8 / 250 = 8 kHz
+    TCCR0A = (1 << WGM01);
+    TCCR0B = (1 << CS01);
+    OCR0A = 249;
+    TIMSK0 |= (1 << OCIE0A);
+}
+
+/**
+ * Take an LED out of PWM control and stop its fade and effect
+ * Call with interrupts disabled
+ * @param pin The pin number of the LED
+ */
+static void led_release(uint8_t pin) {
+    uint8_t index = led_index(pin);
+
+    if (index == LED_COUNT) {
+        return;
+    }
+
+    pwmMask &= ~(1 << pin);
+    fades[index].step = 0;
+    fades[index].breathe = 0;
+    effects[index].length = 0;
 }
 
 void led_on(uint8_t pin) {
-    PORTB &= ~(1 << pin);  // Common anode - LOW = on
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        led_release(pin);
+        PORTB &= ~(1 << pin);  // Common anode - LOW = on
+    }
 }
 
 void led_off(uint8_t pin) {
-    PORTB |= (1 << pin);  // Common anode - HIGH = off
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        led_release(pin);
+        PORTB |= (1 << pin);  // Common anode - HIGH = off
+    }
 }
 
 void led_toggle(uint8_t pin) {
-    PORTB ^= (1 << pin);
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        led_release(pin);
+        PORTB ^= (1 << pin);
+    }
+}
+
+/**
+ * Put an LED under PWM control with a fade toward a target
+ * @param pin The pin number of the LED
+ * @param start Starting brightness, or 0xFF to keep the current one
+ * @param target Target brightness
+ * @param duration_ms Fade time, 0 jumps to the target
+ * @param breathe 1 to keep bouncing between 0 and LED_LEVEL_MAX
+ */
+static void led_start_fade(uint8_t pin, uint8_t start, uint8_t target, uint16_t duration_ms, uint8_t breathe) {
+    uint8_t index = led_index(pin);
+
+    if (index == LED_COUNT) {
+        return;
+    }
+
+    if (target > LED_LEVEL_MAX) {
+        target = LED_LEVEL_MAX;
+    }
+
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        volatile LedFade* fade = &fades[index];
+
+        effects[index].length = 0;
+
+        // An LED switched on/off by hand starts from that level
+        if (!(pwmMask & (1 << pin))) {
+            fade->level = (PORTB & (1 << pin)) ? 0 : (uint16_t)LED_LEVEL_MAX << 8;
+        }
+        if (start <= LED_LEVEL_MAX) {
+            fade->level = (uint16_t)start << 8;
+        }
+
+        uint16_t from = fade->level;
+        uint16_t to = (uint16_t)target << 8;
+        uint16_t distance = (from > to) ? from - to : to - from;
+
+        fade->target = target;
+        fade->breathe = breathe;
+
+        if (duration_ms == 0 || distance == 0) {
+            fade->level = to;
+            fade->step = breathe ? 1 : 0;
+        } else {
+            fade->step = distance / duration_ms;
+            if (fade->step == 0) {
+                fade->step = 1;
+            }
+        }
+
+        ledDuty[index] = led_duty(fade->level);
+        pwmMask |= (1 << pin);
+    }
+}
+
+void led_set_brightness(uint8_t pin, uint8_t level) {
+    led_start_fade(pin, 0xFF, level, 0, 0);
+}
+
+uint8_t led_get_brightness(uint8_t pin) {
+    uint8_t index = led_index(pin);
+    uint8_t level = 0;
+
+    if (index == LED_COUNT) {
+        return 0;
+    }
+
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        if (pwmMask & (1 << pin)) {
+            level = fades[index].level >> 8;
+        }
+    }
+
+    return level;
+}
+
+void led_fade_to(uint8_t pin, uint8_t level, uint16_t duration_ms) {
+    led_start_fade(pin, 0xFF, level, duration_ms, 0);
+}
+
+void led_pulse(uint8_t pin, uint16_t duration_ms) {
+    led_start_fade(pin, LED_LEVEL_MAX, 0, duration_ms, 0);
+}
+
+void led_breathe(uint8_t pin, uint16_t period_ms) {
+    led_start_fade(pin, 0, LED_LEVEL_MAX, period_ms / 2, 1);
+}
+
+void led_set_max_brightness(uint8_t level) {
+    if (level > LED_LEVEL_MAX) {
+        level = LED_LEVEL_MAX;
+    }
+
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        maxLevel = level;
+
+        for (uint8_t i = 0; i < LED_COUNT; i++) {
+            ledDuty[i] = led_duty(fades[i].level);
+        }
+    }
+}
+
+uint8_t led_get_max_brightness(void) {
+    return maxLevel;
+}
+
+uint8_t led_is_fading(uint8_t pin) {
+    uint8_t index = led_index(pin);
+
+    if (index == LED_COUNT) {
+        return 0;
+    }
+
+    return fades[index].step != 0;
+}
+
+void led_effect_start(uint8_t pin, uint8_t pattern, uint8_t length, uint16_t step_ms, uint8_t repeat) {
+    uint8_t index = led_index(pin);
+
+    if (index == LED_COUNT || length == 0 || length > 8 || step_ms == 0) {
+        return;
+    }
+
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        led_release(pin);
+
+        volatile LedEffect* effect = &effects[index];
+        effect->pattern = pattern;
+        effect->length = length;
+        effect->bit = 0;
+        effect->repeat = repeat;
+        effect->step_ms = step_ms;
+        effect->countdown = step_ms;
+
+        led_write(index, pattern & 1);
+    }
+}
+
+void led_effect_cancel(uint8_t pin) {
+    led_off(pin);
+}
+
+uint8_t led_effect_active(uint8_t pin) {
+    uint8_t index = led_index(pin);
+
+    if (index == LED_COUNT) {
+        return 0;
+    }
+
+    return effects[index].length != 0;
 }
 
 void leds_test(void) {
@@ -34,7 +392,15 @@ void leds_test(void) {
 }
 
 void flash_led_briefly(uint8_t pin, uint16_t duration_ms) {
-    led_on(pin);
-    _delay_ms(duration_ms);
-    led_off(pin);
-}
\ No newline at end of file
+    led_effect_start(pin, 0x01, 1, duration_ms, 1);
+}
+
+uint16_t leds_isr_cycles_max(void) {
+    uint16_t cycles;
+
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        cycles = isrCyclesMax;
+    }
+
+    return cycles;
+}
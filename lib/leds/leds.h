@@ -2,52 +2,160 @@
  * LED Control Library for DJ Controller
  * 
  * Provides functions for controlling the LED indicators
+ * leds_init() starts the LED timer on Timer0: an 8 kHz compare interrupt
+ * steps a 64-slot software PWM frame (125 Hz) and once per millisecond
+ * advances fades and blink effects. The interrupt cost is not fixed: the
+ * fade and effect work only runs on every 8th interrupt. Check the worst
+ * case with leds_isr_cycles_max() on the board.
  */
 
 #ifndef LEDS_H
 #define LEDS_H
 
 #include <avr/io.h>
-#include <util/delay.h>
 
 #define LED_PLAY_PIN 2   // PB2
 #define LED_TRACK_PIN 3  // PB3
 #define LED_SEEK_PIN 4   // PB4
 #define LED_STATUS_PIN 5 // PB5
 
+#define LED_COUNT 4
+#define LED_LEVEL_MAX 31   // Brightness levels 0-31, gamma corrected
+#define LED_PWM_STEPS 64   // Duty steps per PWM frame
+
+// Cycles between two LED interrupts; the interrupt must stay well below this
+#define LED_CYCLE_BUDGET 2000
+
+// Reported when the interrupt ran past the next compare match
+#define LED_ISR_OVERRUN 0xFFFF
+
 /**
- * Initialize the LED pins as outputs
+ * Initialize the LED pins as outputs and start the LED timer
+ * Fades and effects run from Timer0, so the program must enable global
+ * interrupts once everything is set up
  */
 void leds_init(void);
 
 /**
  * Turn on an LED
+ * Takes the LED out of PWM control and cancels its fade or effect
  * @param pin The pin number of the LED to turn on
  */
 void led_on(uint8_t pin);
 
 /**
  * Turn off an LED
+ * Takes the LED out of PWM control and cancels its fade or effect
  * @param pin The pin number of the LED to turn off
  */
 void led_off(uint8_t pin);
 
 /**
  * Toggle an LED's state
+ * Takes the LED out of PWM control and cancels its fade or effect
  * @param pin The pin number of the LED to toggle
  */
 void led_toggle(uint8_t pin);
 
+/**
+ * Set an LED to a fixed brightness under PWM control
+ * @param pin The pin number of the LED
+ * @param level Brightness (0 to LED_LEVEL_MAX)
+ */
+void led_set_brightness(uint8_t pin, uint8_t level);
+
+/**
+ * Get the current brightness of an LED under PWM control
+ * @param pin The pin number of the LED
+ * @return Brightness (0 to LED_LEVEL_MAX), 0 if not under PWM control
+ */
+uint8_t led_get_brightness(uint8_t pin);
+
+/**
+ * Fade an LED from its current brightness to a target
+ * @param pin The pin number of the LED
+ * @param level Target brightness (0 to LED_LEVEL_MAX)
+ * @param duration_ms Fade time in milliseconds, 0 sets it at once
+ */
+void led_fade_to(uint8_t pin, uint8_t level, uint16_t duration_ms);
+
+/**
+ * Light an LED at full brightness and fade it out
+ * @param pin The pin number of the LED
+ * @param duration_ms Fade out time in milliseconds
+ */
+void led_pulse(uint8_t pin, uint16_t duration_ms);
+
+/**
+ * Breathe an LED up and down until it is switched or faded
+ * @param pin The pin number of the LED
+ * @param period_ms Time for one full up and down cycle
+ */
+void led_breathe(uint8_t pin, uint16_t period_ms);
+
+/**
+ * Set the brightness ceiling of LEDs under PWM control
+ * Levels from fades, pulses and led_set_brightness are scaled to it
+ * @param level Ceiling (0-LED_LEVEL_MAX)
+ */
+void led_set_max_brightness(uint8_t level);
+
+/**
+ * Get the brightness ceiling
+ * @return Ceiling (0-LED_LEVEL_MAX)
+ */
+uint8_t led_get_max_brightness(void);
+
+/**
+ * Check if an LED is still fading or breathing
+ * @param pin The pin number of the LED
+ * @return 1 if fading, 0 otherwise
+ */
+uint8_t led_is_fading(uint8_t pin);
+
+/**
+ * Start a blink effect, replacing any effect or fade on the LED
+ * Each step shows one bit of the pattern, least significant bit first
+ * @param pin The pin number of the LED
+ * @param pattern Bit pattern, 1 = on, 0 = off
+ * @param length Number of pattern bits to play (1-8)
+ * @param step_ms Time per bit in milliseconds
+ * @param repeat Number of times to play the pattern, 0 = until cancelled
+ */
+void led_effect_start(uint8_t pin, uint8_t pattern, uint8_t length, uint16_t step_ms, uint8_t repeat);
+
+/**
+ * Stop the effect on an LED and switch it off
+ * @param pin The pin number of the LED
+ */
+void led_effect_cancel(uint8_t pin);
+
+/**
+ * Check if an LED is running an effect
+ * @param pin The pin number of the LED
+ * @return 1 if an effect is running, 0 otherwise
+ */
+uint8_t led_effect_active(uint8_t pin);
+
 /**
  * Flash test pattern on all LEDs (for startup)
  */
 void leds_test(void);
 
 /**
- * Flash an LED briefly
+ * Flash an LED briefly without blocking
  * @param pin The pin number of the LED to flash
  * @param duration_ms Duration to keep the LED on in milliseconds
  */
 void flash_led_briefly(uint8_t pin, uint16_t duration_ms);
 
+/**
+ * Get the longest LED interrupt seen since leds_init()
+ * Measured from the Timer0 compare match to the end of the handler, so it
+ * includes interrupt latency; compare against LED_CYCLE_BUDGET
+ * @return CPU cycles in steps of 8, or LED_ISR_OVERRUN once the handler
+ *         ran past the next compare match
+ */
+uint16_t leds_isr_cycles_max(void);
+
 #endif
\ No newline at end of file
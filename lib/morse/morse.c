@@ -0,0 +1,246 @@
+/**
+ * Morse Keyer Implementation for DJ Controller
+ */
+
+#include "morse.h"
+#include <avr/pgmspace.h>
+#include <util/atomic.h>
+
+// Codes for A-Z and 0-9: elements from the least significant bit up,
+// 1 = dash, 0 = dot, ended by a marker bit
+static const uint8_t MORSE_CODES[] PROGMEM = {
+    0x06,  // A .-
+    0x11,  // B -...
+    0x15,  // C -.-.
+    0x09,  // D -..
+    0x02,  // E .
+    0x14,  // F ..-.
+    0x0B,  // G --.
+    0x10,  // H ....
+    0x04,  // I ..
+    0x1E,  // J .---
+    0x0D,  // K -.-
+    0x12,  // L .-..
+    0x07,  // M --
+    0x05,  // N -.
+    0x0F,  // O ---
+    0x16,  // P .--.
+    0x1B,  // Q --.-
+    0x0A,  // R .-.
+    0x08,  // S ...
+    0x03,  // T -
+    0x0C,  // U ..-
+    0x18,  // V ...-
+    0x0E,  // W .--
+    0x19,  // X -..-
+    0x1D,  // Y -.--
+    0x13,  // Z --..
+    0x3F,  // 0 -----
+    0x3E,  // 1 .----
+    0x3C,  // 2 ..---
+    0x38,  // 3 ...--
+    0x30,  // 4 ....-
+    0x20,  // 5 .....
+    0x21,  // 6 -....
+    0x23,  // 7 --...
+    0x27,  // 8 ---..
+    0x2F,  // 9 ----.
+};
+
+#define STATE_IDLE 0
+#define STATE_MARK 1        // Key down for a dot or dash
+#define STATE_ELEMENT_GAP 2 // One unit between elements
+#define STATE_CHAR_GAP 3    // Space after a character or word
+
+static MorseKeyHandler keyHandler = 0;
+
+// Timing in 1/256 ms
+static uint32_t dotTime = 0;
+static uint32_t charGapTime = 0;
+static uint32_t wordGapTime = 0;
+
+static volatile char queue[MORSE_QUEUE_SIZE];
+static volatile uint8_t queueHead = 0;
+static volatile uint8_t queueCount = 0;
+
+static volatile uint8_t state = STATE_IDLE;
+static volatile char currentChar = 0;
+static uint8_t elements = 0;         // Elements left in the current character, with marker
+static int32_t remaining = 0;        // Time left in the current state, 1/256 ms
+
+void morse_init(MorseKeyHandler handler) {
+    keyHandler = handler;
+    morse_stop();
+    morse_set_speed(12, 0);
+}
+
+uint8_t morse_set_speed(uint8_t wpm, uint8_t char_wpm) {
+    if (wpm < MORSE_MIN_WPM || wpm > MORSE_MAX_WPM) {
+        return 0;
+    }
+
+    if (char_wpm == 0) {
+        char_wpm = wpm;
+    }
+
+    if (char_wpm < wpm || char_wpm > MORSE_MAX_WPM) {
+        return 0;
+    }
+
+    // PARIS: one dot is 1200 / wpm ms
+    uint32_t dot = (1200UL << 8) / char_wpm;
+
+    // Farnsworth delay ta = (60000c - 37200s) / (sc) ms spread over the
+    // 19 units of character and word space in PARIS: 3/19 and 7/19 of it.
+    // Without Farnsworth (c = s) this reduces to 3 and 7 dots.
+    uint32_t delay = ((60000UL * char_wpm - 37200UL * wpm) << 8) / ((uint16_t)wpm * char_wpm);
+
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        dotTime = dot;
+        charGapTime = 3 * delay / 19;
+        wordGapTime = 7 * delay / 19;
+    }
+
+    return 1;
+}
+
+/**
+ * Look up the code of a character
+ * @param character Character to send
+ * @return Code with marker bit, 0 if the character has no code
+ */
+static uint8_t morse_code_for(char character) {
+    if (character >= 'a' && character <= 'z') {
+        character -= 'a' - 'A';
+    }
+
+    if (character >= 'A' && character <= 'Z') {
+        return pgm_read_byte(&MORSE_CODES[character - 'A']);
+    }
+    if (character >= '0' && character <= '9') {
+        return pgm_read_byte(&MORSE_CODES[26 + character - '0']);
+    }
+
+    return 0;
+}
+
+uint8_t morse_send(const char* text) {
+    uint8_t queued = 0;
+
+    for (; *text != '\0'; text++) {
+        char character = *text;
+
+        if (character != ' ' && morse_code_for(character) == 0) {
+            continue;
+        }
+
+        ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+            if (queueCount < MORSE_QUEUE_SIZE) {
+                queue[(queueHead + queueCount) % MORSE_QUEUE_SIZE] = character;
+                queueCount++;
+                queued++;
+            }
+        }
+    }
+
+    return queued;
+}
+
+uint8_t morse_busy(void) {
+    return state != STATE_IDLE || queueCount != 0;
+}
+
+char morse_current_char(void) {
+    return currentChar;
+}
+
+void morse_stop(void) {
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        if (state == STATE_MARK && keyHandler) {
+            keyHandler(0);
+        }
+
+        queueCount = 0;
+        state = STATE_IDLE;
+        currentChar = 0;
+        remaining = 0;
+    }
+}
+
+/**
+ * Key down for the next element of the current character
+ */
+static void morse_start_element(void) {
+    remaining += (elements & 1) ? 3 * dotTime : dotTime;
+    elements >>= 1;
+    state = STATE_MARK;
+
+    if (keyHandler) {
+        keyHandler(1);
+    }
+}
+
+/**
+ * Start the next queued character, or go idle
+ */
+static void morse_next_char(void) {
+    if (queueCount == 0) {
+        state = STATE_IDLE;
+        currentChar = 0;
+        remaining = 0;
+        return;
+    }
+
+    char character = queue[queueHead];
+    queueHead = (queueHead + 1) % MORSE_QUEUE_SIZE;
+    queueCount--;
+    currentChar = character;
+
+    if (character == ' ') {
+        // A word gap replaces the character gap already waited
+        remaining += wordGapTime - charGapTime;
+        state = STATE_CHAR_GAP;
+        return;
+    }
+
+    elements = morse_code_for(character);
+    morse_start_element();
+}
+
+void morse_tick(void) {
+    if (state == STATE_IDLE) {
+        if (queueCount != 0) {
+            morse_next_char();
+        }
+        return;
+    }
+
+    remaining -= 256;
+    if (remaining > 0) {
+        return;
+    }
+
+    switch (state) {
+        case STATE_MARK:
+            if (keyHandler) {
+                keyHandler(0);
+            }
+
+            if (elements > 1) {
+                remaining += dotTime;
+                state = STATE_ELEMENT_GAP;
+            } else {
+                remaining += charGapTime;
+                state = STATE_CHAR_GAP;
+            }
+            break;
+
+        case STATE_ELEMENT_GAP:
+            morse_start_element();
+            break;
+
+        case STATE_CHAR_GAP:
+            morse_next_char();
+            break;
+    }
+}
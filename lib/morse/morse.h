@@ -0,0 +1,74 @@
+/**
+ * Morse Keyer Library for DJ Controller
+ * 
+ * Provides a timer-driven Morse code keyer with standard PARIS timing and
+ * optional Farnsworth spacing. Text is queued with morse_send() and keyed
+ * from morse_tick(), called every millisecond, so sending never blocks.
+ * Durations are kept in 1/256 ms and carried over from element to element,
+ * so long transmissions keep exact timing at any speed.
+ */
+
+#ifndef MORSE_H
+#define MORSE_H
+
+#include <avr/io.h>
+
+#define MORSE_MIN_WPM 5
+#define MORSE_MAX_WPM 40
+#define MORSE_QUEUE_SIZE 16
+
+/**
+ * Called when the key goes down or up, from the tick interrupt
+ * @param down 1 at the start of a dot or dash, 0 at its end
+ */
+typedef void (*MorseKeyHandler)(uint8_t down);
+
+/**
+ * Initialize the keyer at 12 WPM without Farnsworth spacing
+ * @param handler Function that switches the tone and lights
+ */
+void morse_init(MorseKeyHandler handler);
+
+/**
+ * Set the sending speed
+ * With Farnsworth timing the dots and dashes use the character speed and
+ * the gaps between characters and words are stretched so the overall
+ * speed comes out at wpm
+ * @param wpm Overall speed in words per minute (MORSE_MIN_WPM to MORSE_MAX_WPM)
+ * @param char_wpm Character speed (wpm to MORSE_MAX_WPM), 0 to disable Farnsworth
+ * @return 1 if successful, 0 if out of range
+ */
+uint8_t morse_set_speed(uint8_t wpm, uint8_t char_wpm);
+
+/**
+ * Queue text for sending
+ * Letters, digits and spaces are sent; other characters are skipped
+ * @param text Null-terminated text
+ * @return Number of characters queued (less than the length when the queue is full)
+ */
+uint8_t morse_send(const char* text);
+
+/**
+ * Check if the keyer is still sending
+ * @return 1 while characters are queued or being sent, 0 when idle
+ */
+uint8_t morse_busy(void);
+
+/**
+ * Get the character currently being sent
+ * @return The character, or 0 when idle
+ */
+char morse_current_char(void);
+
+/**
+ * Stop sending and clear the queue
+ */
+void morse_stop(void);
+
+/**
+ * Advance the keyer by one millisecond
+ * Call from a 1 ms timer interrupt such as systick_hook()
+ */
+void morse_tick(void);
+
+#endif
@@ -3,36 +3,260 @@
  */
 
 #include "playlist.h"
-#include <stdio.h>
+#include "random.h"
+
+/**
+ * Set or clear a track's bit in the played bitset
+ * @param playlist Pointer to the playlist
+ * @param index Index of the track
+ * @param value 1 to set, 0 to clear
+ */
+static void playlist_set_played(Playlist* playlist, uint8_t index, uint8_t value) {
+    uint8_t mask = 1 << (index & 7);
+
+    if (value) {
+        playlist->played[index >> 3] |= mask;
+    } else {
+        playlist->played[index >> 3] &= ~mask;
+    }
+}
+
+/**
+ * Read a track's bit in the played bitset
+ * @param playlist Pointer to the playlist
+ * @param index Index of the track
+ * @return 1 if set, 0 otherwise
+ */
+static uint8_t playlist_was_played(Playlist* playlist, uint8_t index) {
+    return (playlist->played[index >> 3] >> (index & 7)) & 1;
+}
+
+/**
+ * Draw a uniform random number below a bound
+ * Multiply-and-shift on 16 bits of generator output, with a rejection
+ * only in the rare case the low half falls under the threshold
+ * @param bound Upper bound (exclusive, at least 1)
+ * @return Number in 0..bound-1
+ */
+static uint8_t playlist_random_below(uint8_t bound) {
+    uint32_t m = (uint32_t)(uint16_t)(random_global_uint32() >> 16) * bound;
+
+    if ((uint16_t)m < bound) {
+        uint16_t threshold = (uint16_t)(0x10000UL - bound) % bound;
+
+        while ((uint16_t)m < threshold) {
+            m = (uint32_t)(uint16_t)(random_global_uint32() >> 16) * bound;
+        }
+    }
+
+    return m >> 16;
+}
+
+/**
+ * Swap two entries of the shuffle order
+ * @param playlist Pointer to the playlist
+ * @param a First position
+ * @param b Second position
+ */
+static void playlist_swap_order(Playlist* playlist, uint8_t a, uint8_t b) {
+    uint8_t temp = playlist->order[a];
+    playlist->order[a] = playlist->order[b];
+    playlist->order[b] = temp;
+}
+
+/**
+ * Start a new shuffle cycle with the given track first
+ * The rest of the order is drawn as the cycle advances
+ * @param playlist Pointer to the playlist
+ * @param index Index of the first track (must be valid)
+ */
+static void playlist_restart_shuffle(Playlist* playlist, uint8_t index) {
+    for (uint8_t i = 0; i < playlist->count; i++) {
+        playlist->order[i] = i;
+    }
+
+    playlist->order[0] = index;
+    playlist->order[index] = 0;
+    playlist->order_pos = 0;
+}
+
+/**
+ * Add an entry at the end of a ring, dropping the oldest entry when full
+ * @param ring Pointer to the ring
+ * @param index Track index to add
+ */
+static void playlist_ring_push(PlaylistRing* ring, uint8_t index) {
+    ring->items[(ring->head + ring->count) & (PLAYLIST_RING_SIZE - 1)] = index;
+
+    if (ring->count < PLAYLIST_RING_SIZE) {
+        ring->count++;
+    } else {
+        ring->head = (ring->head + 1) & (PLAYLIST_RING_SIZE - 1);
+    }
+}
+
+/**
+ * Take the newest entry off a ring (must not be empty)
+ * @param ring Pointer to the ring
+ * @return Track index
+ */
+static uint8_t playlist_ring_pop_newest(PlaylistRing* ring) {
+    ring->count--;
+    return ring->items[(ring->head + ring->count) & (PLAYLIST_RING_SIZE - 1)];
+}
+
+/**
+ * Take the oldest entry off a ring (must not be empty)
+ * @param ring Pointer to the ring
+ * @return Track index
+ */
+static uint8_t playlist_ring_pop_oldest(PlaylistRing* ring) {
+    uint8_t index = ring->items[ring->head];
+
+    ring->head = (ring->head + 1) & (PLAYLIST_RING_SIZE - 1);
+    ring->count--;
+
+    return index;
+}
+
+/**
+ * Draw the next position of the shuffle order
+ * One Fisher-Yates step; past the end a new cycle starts, and its first
+ * track is never the current one
+ * @param playlist Pointer to the playlist
+ */
+static void playlist_shuffle_step(Playlist* playlist) {
+    uint8_t pos = playlist->order_pos + 1;
+    uint8_t last = playlist->count - 1;
+
+    if (pos > last) {
+        // Park the current track in the last slot so position 0 is drawn
+        // from the others; it can still move up in later draws
+        for (uint8_t i = 0; i < last; i++) {
+            if (playlist->order[i] == playlist->current_index) {
+                playlist_swap_order(playlist, i, last);
+                break;
+            }
+        }
+
+        playlist_swap_order(playlist, 0, playlist_random_below(last));
+        playlist->order_pos = 0;
+        return;
+    }
+
+    playlist_swap_order(playlist, pos, pos + playlist_random_below(playlist->count - pos));
+    playlist->order_pos = pos;
+}
+
+/**
+ * Forget all cue points
+ * @param playlist Pointer to the playlist
+ */
+static void playlist_clear_cues(Playlist* playlist) {
+    for (uint8_t i = 0; i < PLAYLIST_CUES; i++) {
+        playlist->cues[i] = PLAYLIST_CUE_NONE;
+    }
+    playlist->cue_track = 0;
+}
+
+/**
+ * Forget the held display name
+ * @param playlist Pointer to the playlist
+ */
+static void playlist_clear_name(Playlist* playlist) {
+    memset(playlist->name, 0, PLAYLIST_NAME_BYTES);
+    playlist->name_track = 0;
+}
+
+/**
+ * Get the 6-bit code of a character for a packed name
+ * @param c Character
+ * @return Code, 1 (space) for characters the display cannot show
+ */
+static uint8_t playlist_name_code(char c) {
+    if (c >= '0' && c <= '9') {
+        return 2 + (c - '0');
+    }
+    if (c >= 'A' && c <= 'Z') {
+        return 12 + (c - 'A');
+    }
+    if (c >= 'a' && c <= 'z') {
+        return 12 + (c - 'a');
+    }
+    return 1;
+}
+
+/**
+ * Get the character of a packed name code
+ * @param code 6-bit code, not 0
+ * @return Character
+ */
+static char playlist_name_char(uint8_t code) {
+    if (code >= 12) {
+        return 'A' + (code - 12);
+    }
+    if (code >= 2) {
+        return '0' + (code - 2);
+    }
+    return ' ';
+}
+
+/**
+ * Read one character code of a packed name
+ * @param bytes Packed name
+ * @param pos Character position (0 to PLAYLIST_NAME_LENGTH - 1)
+ * @return 6-bit code, 0 past the end of the name
+ */
+static uint8_t playlist_unpack_code(const uint8_t* bytes, uint8_t pos) {
+    uint8_t bit = pos * 6;
+    uint8_t shift = bit & 7;
+    uint8_t code = bytes[bit >> 3] >> shift;
+
+    // Codes at a shift above 2 continue in the next byte
+    if (shift > 2) {
+        code |= bytes[(bit >> 3) + 1] << (8 - shift);
+    }
+
+    return code & 0x3F;
+}
 
 Playlist* playlist_create(uint8_t capacity) {
-    Playlist* playlist = (Playlist*)malloc(sizeof(Playlist));
+    if (capacity > PLAYLIST_MAX_TRACKS) {
+        return NULL;
+    }
+
+    Playlist* playlist = (Playlist*)arena_alloc(sizeof(Playlist));
     
     if (playlist == NULL) {
         return NULL;
     }
    
-    playlist->tracks = (Track*)malloc(sizeof(Track) * capacity);
+    playlist->durations = (uint16_t*)arena_alloc(sizeof(uint16_t) * capacity);
+    playlist->played = (uint8_t*)arena_alloc(PLAYLIST_BITSET_BYTES(capacity));
+    playlist->order = (uint8_t*)arena_alloc(capacity);
     
-    if (playlist->tracks == NULL) {
-        free(playlist);
+    if (playlist->durations == NULL || playlist->played == NULL || playlist->order == NULL) {
+        arena_release(playlist);
         return NULL;
     }
 
     playlist->capacity = capacity;
     playlist->count = 0;
     playlist->current_index = 0;
+    playlist->is_playing = 0;
+    playlist->shuffle = 0;
+    playlist->order_pos = 0;
     playlist->display_needs_update = 0;
+    playlist->scroll_steps = 0;
+    playlist_clear_cues(playlist);
+    playlist_clear_name(playlist);
     
     return playlist;
 }
 
 void playlist_destroy(Playlist* playlist) {
     if (playlist != NULL) {
-        if (playlist->tracks != NULL) {
-            free(playlist->tracks);
-        }
-        free(playlist);
+        arena_release(playlist);
     }
 }
 
@@ -41,40 +265,193 @@ uint8_t playlist_add_track(Playlist* playlist, Track* track) {
         return 0; 
     }
     
-    if (playlist->count >= playlist->capacity) {
+    return playlist_append_track(playlist, track->duration_sec);
+}
+
+uint8_t playlist_append_track(Playlist* playlist, uint16_t duration_sec) {
+    if (playlist == NULL || playlist->count >= playlist->capacity) {
         return 0;
     }
-    
-    memcpy(&(playlist->tracks[playlist->count]), track, sizeof(Track));
-   
+
+    playlist->durations[playlist->count] = duration_sec;
+    playlist_set_played(playlist, playlist->count, 0);
+    // Lands in the part of the shuffle order that is still to be drawn
+    playlist->order[playlist->count] = playlist->count;
+
     playlist->count++;
-    
-    return 1; 
+
+    return 1;
+}
+
+uint8_t playlist_remove_last_track(Playlist* playlist) {
+    if (playlist == NULL || playlist->count == 0) {
+        return 0;
+    }
+
+    playlist->count--;
+
+    if (playlist->count == 0) {
+        playlist->current_index = 0;
+    } else if (playlist->current_index >= playlist->count) {
+        playlist->current_index = playlist->count - 1;
+        playlist->display_needs_update = 1;
+    }
+
+    if (playlist->shuffle && playlist->count > 0) {
+        playlist_restart_shuffle(playlist, playlist->current_index);
+    }
+
+    if (playlist->cue_track >= playlist->count) {
+        playlist_clear_cues(playlist);
+    }
+
+    if (playlist->name_track >= playlist->count) {
+        playlist_clear_name(playlist);
+    }
+
+    return 1;
+}
+
+void playlist_clear(Playlist* playlist) {
+    if (playlist == NULL) {
+        return;
+    }
+
+    playlist->count = 0;
+    playlist->current_index = 0;
+    playlist->order_pos = 0;
+    playlist->history.count = 0;
+    playlist->queue.count = 0;
+    playlist_clear_cues(playlist);
+    playlist_clear_name(playlist);
+}
+
+void playlist_format_name(uint8_t number, char* buffer) {
+    buffer[0] = 'T';
+    buffer[1] = 'R';
+    buffer[2] = '0' + (number / 10) % 10;
+    buffer[3] = '0' + number % 10;
+    buffer[4] = '\0';
 }
 
-Track* playlist_get_track(Playlist* playlist, uint8_t index) {
+uint8_t playlist_set_name(Playlist* playlist, uint8_t index, const char* name) {
     if (playlist == NULL || index >= playlist->count) {
-        return NULL;
+        return 0;
+    }
+
+    // The current track's name may be replaced, or be the one that arrives
+    if (index == playlist->current_index || playlist->name_track == playlist->current_index) {
+        playlist->display_needs_update = 1;
+    }
+
+    uint8_t* bytes = playlist->name;
+    memset(bytes, 0, PLAYLIST_NAME_BYTES);
+    playlist->name_track = index;
+
+    for (uint8_t pos = 0; pos < PLAYLIST_NAME_LENGTH && name[pos] != '\0'; pos++) {
+        uint8_t code = playlist_name_code(name[pos]);
+        uint8_t bit = pos * 6;
+        uint8_t shift = bit & 7;
+
+        bytes[bit >> 3] |= code << shift;
+        if (shift > 2) {
+            bytes[(bit >> 3) + 1] |= code >> (8 - shift);
+        }
+    }
+
+    return 1;
+}
+
+uint8_t playlist_get_name(Playlist* playlist, uint8_t index, char* buffer) {
+    if (playlist == NULL || index >= playlist->count) {
+        return 0;
+    }
+
+    const uint8_t* bytes = playlist->name;
+    uint8_t length = 0;
+    uint8_t code;
+
+    while (index == playlist->name_track && length < PLAYLIST_NAME_LENGTH &&
+           (code = playlist_unpack_code(bytes, length)) != 0) {
+        buffer[length++] = playlist_name_char(code);
+    }
+
+    if (length == 0) {
+        playlist_format_name(index + 1, buffer);
+        return 4;
+    }
+
+    buffer[length] = '\0';
+
+    return length;
+}
+
+uint8_t playlist_get_track(Playlist* playlist, uint8_t index, Track* track) {
+    if (playlist == NULL || track == NULL || index >= playlist->count) {
+        return 0;
     }
     
-    return &(playlist->tracks[index]);
+    track->number = index + 1;
+    track->duration_sec = playlist->durations[index];
+    track->isPlaying = playlist->is_playing && index == playlist->current_index;
+    track->played = playlist_was_played(playlist, index);
+
+    return 1;
 }
 
-Track* playlist_get_current_track(Playlist* playlist) {
+uint8_t playlist_get_current_track(Playlist* playlist, Track* track) {
     if (playlist == NULL || playlist->count == 0) {
-        return NULL; 
+        return 0; 
     }
     
-    return &(playlist->tracks[playlist->current_index]);
+    return playlist_get_track(playlist, playlist->current_index, track);
+}
+
+uint8_t playlist_set_duration(Playlist* playlist, uint8_t index, uint16_t duration_sec) {
+    if (playlist == NULL || index >= playlist->count) {
+        return 0;
+    }
+
+    playlist->durations[index] = duration_sec;
+
+    return 1;
+}
+
+/**
+ * Move the current position
+ * @param playlist Pointer to the playlist
+ * @param index New current index (must be valid)
+ * @param remember 1 to push the track that is left onto the history
+ */
+static void playlist_move_current(Playlist* playlist, uint8_t index, uint8_t remember) {
+    if (remember && index != playlist->current_index) {
+        playlist_ring_push(&playlist->history, playlist->current_index);
+    }
+
+    playlist->current_index = index;
+    playlist->display_needs_update = 1;
+
+    if (playlist->is_playing) {
+        playlist_set_played(playlist, index, 1);
+    }
 }
 
 uint8_t playlist_set_current_track(Playlist* playlist, uint8_t index) {
     if (playlist == NULL || index >= playlist->count) {
         return 0; 
     }
+
+    PlaylistRing* queue = &playlist->queue;
+
+    if (queue->count > 0 && queue->items[queue->head] == index) {
+        playlist_ring_pop_oldest(queue);
+    }
+
+    if (playlist->shuffle && index != playlist->current_index) {
+        playlist_restart_shuffle(playlist, index);
+    }
     
-    playlist->current_index = index;
-    playlist->display_needs_update = 1;
+    playlist_move_current(playlist, index, 1);
     
     return 1;
 }
@@ -84,8 +461,31 @@ uint8_t playlist_next_track(Playlist* playlist) {
         return 0; 
     }
 
-    playlist->current_index = (playlist->current_index + 1) % playlist->count;
-    playlist->display_needs_update = 1;
+    // Entries left over from removed tracks are skipped
+    while (playlist->queue.count > 0) {
+        uint8_t index = playlist_ring_pop_oldest(&playlist->queue);
+
+        if (index < playlist->count && index != playlist->current_index) {
+            playlist_move_current(playlist, index, 1);
+            return 1;
+        }
+    }
+
+    if (playlist->shuffle) {
+        playlist_shuffle_step(playlist);
+
+        // The current track came from the queue or the history and was
+        // still ahead in this cycle
+        if (playlist->order[playlist->order_pos] == playlist->current_index) {
+            playlist_shuffle_step(playlist);
+        }
+
+        playlist_move_current(playlist, playlist->order[playlist->order_pos], 1);
+
+        return 1;
+    }
+
+    playlist_move_current(playlist, (playlist->current_index + 1) % playlist->count, 1);
     
     return 1;
 }
@@ -94,43 +494,157 @@ uint8_t playlist_prev_track(Playlist* playlist) {
     if (playlist == NULL || playlist->count <= 1) {
         return 0;
     }
+
+    while (playlist->history.count > 0) {
+        uint8_t index = playlist_ring_pop_newest(&playlist->history);
+
+        if (index < playlist->count && index != playlist->current_index) {
+            playlist_move_current(playlist, index, 0);
+            return 1;
+        }
+    }
+
+    if (playlist->shuffle) {
+        return 0;
+    }
     
     if (playlist->current_index == 0) {
-        playlist->current_index = playlist->count - 1;
+        playlist_move_current(playlist, playlist->count - 1, 0);
     } else {
-        playlist->current_index--;
+        playlist_move_current(playlist, playlist->current_index - 1, 0);
     }
     
-    playlist->display_needs_update = 1;
-    
     return 1;
 }
 
+uint8_t playlist_enqueue(Playlist* playlist, uint8_t index) {
+    if (playlist == NULL || index >= playlist->count ||
+        playlist->queue.count >= PLAYLIST_RING_SIZE) {
+        return 0;
+    }
+
+    playlist_ring_push(&playlist->queue, index);
+
+    return 1;
+}
+
+void playlist_clear_queue(Playlist* playlist) {
+    if (playlist != NULL) {
+        playlist->queue.count = 0;
+    }
+}
+
+void playlist_clear_history(Playlist* playlist) {
+    if (playlist != NULL) {
+        playlist->history.count = 0;
+    }
+}
+
+uint8_t playlist_set_cue(Playlist* playlist, uint8_t index, uint8_t cue, uint16_t seconds) {
+    if (playlist == NULL || index >= playlist->count || cue >= PLAYLIST_CUES) {
+        return 0;
+    }
+
+    if (index != playlist->cue_track) {
+        playlist_clear_cues(playlist);
+        playlist->cue_track = index;
+    }
+
+    playlist->cues[cue] = seconds;
+
+    return 1;
+}
+
+uint8_t playlist_get_cue(Playlist* playlist, uint8_t cue, uint16_t* seconds) {
+    if (playlist == NULL || playlist->count == 0 || cue >= PLAYLIST_CUES ||
+        playlist->cue_track != playlist->current_index ||
+        playlist->cues[cue] == PLAYLIST_CUE_NONE) {
+        return 0;
+    }
+
+    *seconds = playlist->cues[cue];
+
+    return 1;
+}
+
+void playlist_set_shuffle(Playlist* playlist, uint8_t enabled) {
+    if (playlist == NULL) {
+        return;
+    }
+
+    playlist->shuffle = enabled ? 1 : 0;
+
+    if (playlist->shuffle && playlist->count > 0) {
+        playlist_restart_shuffle(playlist, playlist->current_index);
+    }
+}
+
 void playlist_set_playing(Playlist* playlist, uint8_t isPlaying) {
     if (playlist == NULL || playlist->count == 0) {
         return; 
     }
     
-    Track* current = &(playlist->tracks[playlist->current_index]);
-    current->isPlaying = isPlaying;
+    playlist->is_playing = isPlaying;
+    if (isPlaying) {
+        playlist_set_played(playlist, playlist->current_index, 1);
+    }
     playlist->display_needs_update = 1;
 }
 
+/**
+ * Show the name window at the current scroll position
+ * @param playlist Pointer to the playlist
+ */
+static void playlist_show_scroll(Playlist* playlist) {
+    char name[PLAYLIST_NAME_LENGTH + 1];
+    uint8_t length = playlist_get_name(playlist, playlist->current_index, name);
+    uint8_t pos = playlist->scroll_pos;
+
+    // The last steps of a short name keep showing it
+    if (pos + 4 > length) {
+        pos = (length > 4) ? length - 4 : 0;
+    }
+
+    display_string(name + pos);
+}
+
 void playlist_check_update(Playlist* playlist) {
-    if (playlist == NULL || !playlist->display_needs_update) {
+    if (playlist == NULL) {
         return;
     }
-    
-    playlist->display_needs_update = 0;
-    
-    if (playlist->count == 0) {
+
+    uint16_t now = (uint16_t)systick_millis();
+
+    if (playlist->display_needs_update) {
+        playlist->display_needs_update = 0;
+        playlist->scroll_steps = 0;
+
+        if (playlist->count == 0) {
+            return;
+        }
+
+        char name[PLAYLIST_NAME_LENGTH + 1];
+        uint8_t length = playlist_get_name(playlist, playlist->current_index, name);
+
+        // Every position of a long name, a short one is held for two steps
+        playlist->scroll_steps = (length > 4) ? length - 3 : 2;
+        playlist->scroll_pos = 0;
+        playlist->scroll_time = now;
+        playlist_show_scroll(playlist);
         return;
     }
-   
-    Track* current = &(playlist->tracks[playlist->current_index]);
-   
-    char trackDisplay[5];
-    sprintf(trackDisplay, "TR%02d", current->number);
- 
-    display_message(trackDisplay, 200);
-}
\ No newline at end of file
+
+    if (playlist->scroll_steps == 0 || (uint16_t)(now - playlist->scroll_time) < PLAYLIST_SCROLL_MS) {
+        return;
+    }
+
+    playlist->scroll_time = now;
+
+    if (++playlist->scroll_pos >= playlist->scroll_steps) {
+        playlist->scroll_steps = 0;
+        display_string(playlist->is_playing ? "PLAY" : "PAUS");
+        return;
+    }
+
+    playlist_show_scroll(playlist);
+}
@@ -2,50 +2,128 @@
  * Playlist Management Library for DJ Controller
  * 
  * Provides structs and functions for managing a playlist of tracks
- * Demonstrates struct usage and dynamic memory allocation
+ * Playlists are allocated from the static arena (lib/arena), not the heap
  */
 
 #ifndef PLAYLIST_H
 #define PLAYLIST_H
 
-#include <avr/io.h>
+#include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
+#include "arena.h"
 
-// Forward declaration to avoid circular dependency errors
-void display_message(const char* str, uint16_t display_time);
+// Declared here instead of including display.h and systick.h, which need
+// the AVR headers, so the playlist also builds on a PC
+void display_string(const char* str);
+uint32_t systick_millis(void);
 
+#define PLAYLIST_DEFAULT_DURATION 180
+#define PLAYLIST_MAX_TRACKS 99    // Track numbers are shown with two digits
+#define PLAYLIST_RING_SIZE 16     // Entries in the history and up-next rings, power of two
+#define PLAYLIST_CUES 4           // Cue points per track
+#define PLAYLIST_CUE_NONE 0xFFFF  // Cue point not set
+#define PLAYLIST_NAME_LENGTH 8    // Characters of a display name
+#define PLAYLIST_NAME_BYTES 6     // Bytes of a packed display name, 6 bits per character
+#define PLAYLIST_SCROLL_MS 400    // Time each position of a scrolling name is shown
+
+/*
+ * Tracks are stored as a structure of arrays: one 16-bit duration per
+ * track and one bit per track in the played bitset, about 2.1 bytes per
+ * track. The track number is the index + 1, names are formatted from the
+ * number when shown, and only the current track can be playing.
+ *
+ * Shuffle mode walks a permutation of the track indices kept in the order
+ * array. The permutation is drawn one step at a time (an in-place
+ * Fisher-Yates spread over the NEXT presses), so each step is O(1) and
+ * needs no extra memory. A new cycle never starts with the track that
+ * ended the previous one.
+ *
+ * Every move to another track pushes the track that was left onto the
+ * play history, and PREV pops it again, so PREV returns to the track
+ * that actually played before. The up-next queue holds tracks to play
+ * before the regular (or shuffled) next track. Both are rings of
+ * PLAYLIST_RING_SIZE entries; a full history drops its oldest entry.
+ *
+ * Cue points of all tracks are kept by the Java application; the playlist
+ * holds the PLAYLIST_CUES cue points of one track, normally the current
+ * one, as sent over serial. Storing them for every track would take
+ * about 800 bytes of RAM.
+ *
+ * Display names are kept the same way: the playlist holds the name of one
+ * track, normally the current one, as sent over serial. A name table for
+ * every track would take about 600 bytes of RAM. The name is packed 6 bits
+ * per character (digits, letters and space, all the display can show) in
+ * PLAYLIST_NAME_BYTES and ends at the first empty character. Other tracks
+ * are shown as "TR01". Names longer than the display scroll through it
+ * without blocking the main loop.
+ */
+
+// Copy of one track's data, filled in by playlist_get_track()
 typedef struct {
-    char name[5];          
     uint8_t number;        
     uint16_t duration_sec; 
     uint8_t isPlaying;     
+    uint8_t played;        // Has been the current track while playing
 } Track;
 
 
+// Fixed-size ring of track indices
+typedef struct {
+    uint8_t items[PLAYLIST_RING_SIZE];
+    uint8_t head;          // Position of the oldest entry
+    uint8_t count;
+} PlaylistRing;
+
 typedef struct Playlist {
-    Track* tracks;         
+    uint16_t* durations;   // Duration of each track in seconds
+    uint8_t* played;       // Bitset, one bit per track
+    uint8_t* order;        // Shuffle order, a permutation of the track indices
     uint8_t capacity;    
     uint8_t count;       
     uint8_t current_index;
+    uint8_t is_playing;    // Play status of the current track
+    uint8_t shuffle;       // Shuffle mode on
+    uint8_t order_pos;     // Position of the current track in order
+    PlaylistRing history;  // Tracks played before the current one, newest last
+    PlaylistRing queue;    // Up-next tracks, oldest first
+    uint16_t cues[PLAYLIST_CUES]; // Cue points of cue_track in seconds
+    uint8_t cue_track;     // Index of the track the cue points belong to
+    uint8_t name[PLAYLIST_NAME_BYTES]; // Packed display name of name_track
+    uint8_t name_track;    // Index of the track the name belongs to
     uint8_t display_needs_update; 
+    uint8_t scroll_pos;    // Name position shown on the display
+    uint8_t scroll_steps;  // Positions of the name being shown, 0 when idle
+    uint16_t scroll_time;  // Time the current position was shown, systick milliseconds
 } Playlist;
 
+// Bytes of the played bitset for a capacity
+#define PLAYLIST_BITSET_BYTES(capacity) (((capacity) + 7) / 8)
+
+// Arena bytes taken by a playlist, for ARENA_CHECK()
+#define PLAYLIST_ARENA_BYTES(capacity)                          \
+    (ARENA_BYTES(sizeof(Playlist)) +                            \
+     ARENA_BYTES((capacity) * sizeof(uint16_t)) +               \
+     ARENA_BYTES(PLAYLIST_BITSET_BYTES(capacity)) +             \
+     ARENA_BYTES(capacity))
+
 /**
  * Create a new playlist with specified capacity
- * @param capacity Maximum number of tracks
- * @return Pointer to the created playlist or NULL on failure
+ * @param capacity Maximum number of tracks (up to PLAYLIST_MAX_TRACKS)
+ * @return Pointer to the created playlist or NULL if the arena is full
  */
 Playlist* playlist_create(uint8_t capacity);
 
 /**
  * Free memory used by a playlist
+ * Releases the playlist and everything allocated from the arena after it
  * @param playlist Pointer to the playlist
  */
 void playlist_destroy(Playlist* playlist);
 
 /**
  * Add a track to the playlist
+ * Only the duration is taken, the track gets the next number
  * @param playlist Pointer to the playlist
  * @param track Pointer to the track to add
  * @return 1 if successful, 0 if playlist is full
@@ -53,22 +131,87 @@ void playlist_destroy(Playlist* playlist);
 uint8_t playlist_add_track(Playlist* playlist, Track* track);
 
 /**
- * Get a track by index
+ * Append the next numbered track at the end of the playlist
+ * Only the new entry is written
+ * @param playlist Pointer to the playlist
+ * @param duration_sec Duration of the track in seconds
+ * @return 1 if successful, 0 if playlist is full
+ */
+uint8_t playlist_append_track(Playlist* playlist, uint16_t duration_sec);
+
+/**
+ * Remove the last track of the playlist
+ * Moves the current track back if it was the removed one
+ * @param playlist Pointer to the playlist
+ * @return 1 if successful, 0 if playlist is empty
+ */
+uint8_t playlist_remove_last_track(Playlist* playlist);
+
+/**
+ * Remove all tracks from the playlist
+ * @param playlist Pointer to the playlist
+ */
+void playlist_clear(Playlist* playlist);
+
+/**
+ * Format a track name for the display ("TR01")
+ * @param number Track number (0-99)
+ * @param buffer Buffer of at least 5 characters
+ */
+void playlist_format_name(uint8_t number, char* buffer);
+
+/**
+ * Set the display name of a track
+ * Replaces the name held for any other track. Lowercase letters are shown
+ * as uppercase, characters the display cannot show become spaces. Longer
+ * names are cut at PLAYLIST_NAME_LENGTH
+ * @param playlist Pointer to the playlist
+ * @param index Index of the track
+ * @param name Name, may be empty to go back to the numbered name
+ * @return 1 if successful, 0 if index is invalid
+ */
+uint8_t playlist_set_name(Playlist* playlist, uint8_t index, const char* name);
+
+/**
+ * Get the display name of a track
+ * Tracks other than the one whose name is held get the numbered name
+ * @param playlist Pointer to the playlist
+ * @param index Index of the track
+ * @param buffer Buffer of at least PLAYLIST_NAME_LENGTH + 1 characters
+ * @return Length of the name, 0 if index is invalid
+ */
+uint8_t playlist_get_name(Playlist* playlist, uint8_t index, char* buffer);
+
+/**
+ * Get a copy of a track by index
  * @param playlist Pointer to the playlist
  * @param index Index of the track to get
- * @return Pointer to the track or NULL if index is invalid
+ * @param track Filled in with the track's data
+ * @return 1 if successful, 0 if index is invalid
+ */
+uint8_t playlist_get_track(Playlist* playlist, uint8_t index, Track* track);
+
+/**
+ * Get a copy of the current track
+ * @param playlist Pointer to the playlist
+ * @param track Filled in with the track's data
+ * @return 1 if successful, 0 if no tracks
  */
-Track* playlist_get_track(Playlist* playlist, uint8_t index);
+uint8_t playlist_get_current_track(Playlist* playlist, Track* track);
 
 /**
- * Get the current track
+ * Set the duration of a track
  * @param playlist Pointer to the playlist
- * @return Pointer to the current track or NULL if no tracks
+ * @param index Index of the track
+ * @param duration_sec Duration in seconds
+ * @return 1 if successful, 0 if index is invalid
  */
-Track* playlist_get_current_track(Playlist* playlist);
+uint8_t playlist_set_duration(Playlist* playlist, uint8_t index, uint16_t duration_sec);
 
 /**
  * Set the current track by index
+ * A jump to the first up-next track takes it off the queue. In shuffle
+ * mode, jumping to another track starts a new shuffle cycle
  * @param playlist Pointer to the playlist
  * @param index Index of the track to set as current
  * @return 1 if successful, 0 if index is invalid
@@ -77,6 +220,8 @@ uint8_t playlist_set_current_track(Playlist* playlist, uint8_t index);
 
 /**
  * Move to next track
+ * Takes the first up-next track if there is one, otherwise the next
+ * track of the shuffle order or the playlist
  * @param playlist Pointer to the playlist
  * @return 1 if successful, 0 if no next track
  */
@@ -84,11 +229,62 @@ uint8_t playlist_next_track(Playlist* playlist);
 
 /**
  * Move to previous track
+ * Returns to the last track of the play history. Without history this is
+ * the track before the current one, or nothing in shuffle mode
  * @param playlist Pointer to the playlist
  * @return 1 if successful, 0 if no previous track
  */
 uint8_t playlist_prev_track(Playlist* playlist);
 
+/**
+ * Add a track to the end of the up-next queue
+ * @param playlist Pointer to the playlist
+ * @param index Index of the track
+ * @return 1 if successful, 0 if the index is invalid or the queue is full
+ */
+uint8_t playlist_enqueue(Playlist* playlist, uint8_t index);
+
+/**
+ * Remove all tracks from the up-next queue
+ * @param playlist Pointer to the playlist
+ */
+void playlist_clear_queue(Playlist* playlist);
+
+/**
+ * Forget the play history
+ * @param playlist Pointer to the playlist
+ */
+void playlist_clear_history(Playlist* playlist);
+
+/**
+ * Set a cue point of a track
+ * Setting a cue point of another track than the one held forgets the
+ * cue points held so far
+ * @param playlist Pointer to the playlist
+ * @param index Index of the track
+ * @param cue Cue number (0 to PLAYLIST_CUES - 1)
+ * @param seconds Position in seconds, or PLAYLIST_CUE_NONE to clear it
+ * @return 1 if successful, 0 if the index or cue is invalid
+ */
+uint8_t playlist_set_cue(Playlist* playlist, uint8_t index, uint8_t cue, uint16_t seconds);
+
+/**
+ * Get a cue point of the current track
+ * @param playlist Pointer to the playlist
+ * @param cue Cue number (0 to PLAYLIST_CUES - 1)
+ * @param seconds Filled in with the position in seconds
+ * @return 1 if the cue point is set, 0 otherwise
+ */
+uint8_t playlist_get_cue(Playlist* playlist, uint8_t cue, uint16_t* seconds);
+
+/**
+ * Turn shuffle mode on or off
+ * A new shuffle cycle starts at the current track
+ * @param playlist Pointer to the playlist
+ * @param enabled 1 for shuffle, 0 for playlist order
+ */
+void playlist_set_shuffle(Playlist* playlist, uint8_t enabled);
+
 /**
  * Set play status of current track
  * @param playlist Pointer to the playlist
@@ -98,6 +294,8 @@ void playlist_set_playing(Playlist* playlist, uint8_t isPlaying);
 
 /**
  * Check if display needs updating and handle it
+ * Shows the current track's name, scrolling one position every
+ * PLAYLIST_SCROLL_MS, then the play state again. Never blocks
  * @param playlist Pointer to the playlist
  */
 void playlist_check_update(Playlist* playlist);
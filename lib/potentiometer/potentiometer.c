@@ -6,12 +6,24 @@
 #include "leds.h"
 #include "display.h"
 #include "commands.h"
+#include "systick.h"
 #include <stdlib.h>
 #include <util/delay.h>
 
 static uint16_t baselineValue = 0;
 static uint8_t potInitialized = 0;
 static uint16_t seekCooldown = 0; 
+static uint8_t potMode = POT_MODE_RELATIVE;
+static uint16_t scrubPermille = 0;
+static MapScale scrubScale;
+static uint32_t scrubLastSent = 0;
+
+static const AdcScanChannel* scanChannels = NULL;
+static uint8_t scanCount = 0;
+static uint8_t scanSlot = 0;
+static uint8_t scanPending = 0;
+static uint16_t scanAccum[ADC_SCAN_MAX_CHANNELS];
+static uint16_t scanReported[ADC_SCAN_MAX_CHANNELS];
 
 void potentiometer_init(void) {
     // Set potentiometer pin as input (no pull-up)
@@ -27,9 +39,21 @@ void potentiometer_init(void) {
     baselineValue = read_adc(POT_PIN);
     potInitialized = 0;
     seekCooldown = 0;
+
+    map_scale_init(&scrubScale, 0, 1023, 0, 1000);
+}
+
+void potentiometer_set_mode(uint8_t mode) {
+    potMode = mode;
+    potInitialized = 0;
+    seekCooldown = 0;
 }
 
 uint16_t read_adc(uint8_t channel) {
+    // Let a running scanner conversion finish, its result is discarded below
+    while (ADCSRA & (1 << ADSC));
+    scanPending = 0;
+
     ADMUX = (ADMUX & 0xF0) | (channel & 0x0F);
 
     ADCSRA |= (1 << ADSC);
@@ -39,17 +63,139 @@ uint16_t read_adc(uint8_t channel) {
     return ADC;
 }
 
-int32_t map_value(int32_t x, int32_t in_min, int32_t in_max, int32_t out_min, int32_t out_max) {
-    return (x - in_min) * (out_max - out_min) / (in_max - in_min) + out_min;
+static void adc_scan_start(uint8_t slot) {
+    ADMUX = (ADMUX & 0xF0) | (scanChannels[slot].channel & 0x0F);
+    ADCSRA |= (1 << ADSC);
+    scanPending = 1;
+}
+
+void adc_scan_init(const AdcScanChannel* channels, uint8_t count) {
+    if (count > ADC_SCAN_MAX_CHANNELS) {
+        count = ADC_SCAN_MAX_CHANNELS;
+    }
+
+    scanCount = 0;
+
+    // Seed every filter with a real reading so the first report is not a jump from 0
+    for (uint8_t i = 0; i < count; i++) {
+        uint16_t sample = read_adc(channels[i].channel);
+        scanAccum[i] = sample << channels[i].filter_shift;
+        scanReported[i] = sample;
+    }
+
+    scanChannels = channels;
+    scanCount = count;
+    scanSlot = 0;
+
+    if (scanCount > 0) {
+        adc_scan_start(scanSlot);
+    }
+}
+
+void adc_scan_update(void) {
+    if (scanCount == 0) {
+        return;
+    }
+
+    if (!scanPending) {
+        adc_scan_start(scanSlot);
+        return;
+    }
+
+    if (ADCSRA & (1 << ADSC)) {
+        return;
+    }
+
+    uint16_t sample = ADC;
+    uint8_t shift = scanChannels[scanSlot].filter_shift;
+    scanAccum[scanSlot] = scanAccum[scanSlot] - (scanAccum[scanSlot] >> shift) + sample;
+
+    scanSlot++;
+    if (scanSlot >= scanCount) {
+        scanSlot = 0;
+    }
+
+    adc_scan_start(scanSlot);
+}
+
+uint16_t adc_scan_value(uint8_t slot) {
+    if (slot >= scanCount) {
+        return 0;
+    }
+
+    return scanAccum[slot] >> scanChannels[slot].filter_shift;
+}
+
+uint8_t adc_scan_changed(uint8_t mask) {
+    uint8_t changed = 0;
+
+    for (uint8_t slot = 0; slot < scanCount; slot++) {
+        if (!(mask & (1 << slot))) {
+            continue;
+        }
+
+        uint16_t value = adc_scan_value(slot);
+        int16_t delta = (int16_t)value - (int16_t)scanReported[slot];
+
+        if ((uint16_t)abs(delta) >= scanChannels[slot].threshold) {
+            scanReported[slot] = value;
+            changed |= (1 << slot);
+        }
+    }
+
+    return changed;
+}
+
+void controls_check(void) {
+    adc_scan_update();
+
+    // The seek pot has its own handling in potentiometer_check()
+    uint8_t changed = adc_scan_changed((uint8_t)~(1 << CONTROL_SEEK));
+
+    if (changed) {
+        send_controls_report(changed);
+    }
+}
+
+static void potentiometer_scrub(uint16_t value) {
+    uint16_t permille = (uint16_t)map_value_scaled(&scrubScale, value);
+
+    // Take the position at startup as reference, only real pot movement seeks
+    if (!potInitialized) {
+        scrubPermille = permille;
+        potInitialized = 1;
+        return;
+    }
+
+    uint32_t now = systick_millis();
+    if (now - scrubLastSent < 1000 / SCRUB_MAX_RATE) {
+        return;
+    }
+
+    int16_t delta = (int16_t)permille - (int16_t)scrubPermille;
+    uint8_t atEnd = (permille == 0 || permille == 1000) && delta != 0;
+
+    if (abs(delta) < SCRUB_HYSTERESIS && !atEnd) {
+        return;
+    }
+
+    scrubPermille = permille;
+    scrubLastSent = now;
+    send_seek_position(permille);
 }
 
 void potentiometer_check(void) {
+    if (potMode == POT_MODE_SCRUB) {
+        potentiometer_scrub((scanCount > CONTROL_SEEK) ? adc_scan_value(CONTROL_SEEK) : read_adc(POT_PIN));
+        return;
+    }
+
     if (seekCooldown > 0) {
         seekCooldown--;
         return;
     }
     
-    uint16_t currentValue = read_adc(POT_PIN);
+    uint16_t currentValue = (scanCount > CONTROL_SEEK) ? adc_scan_value(CONTROL_SEEK) : read_adc(POT_PIN);
     
     if (!potInitialized) {
         baselineValue = currentValue;
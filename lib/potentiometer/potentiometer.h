@@ -8,10 +8,42 @@
 #define POTENTIOMETER_H
 
 #include <avr/io.h>
+#include "fixedpoint.h"
 
 // Potentiometer pin
 #define POT_PIN 0   // PC0 (ADC0)
 
+// Additional control pots (A4/A5 are free on the shield, ADC6/ADC7 only exist on SMD parts)
+#define VOLUME_POT_PIN 4     // PC4 (ADC4)
+#define BPM_POT_PIN 5        // PC5 (ADC5)
+#define CROSSFADE_POT_PIN 6  // ADC6
+#define EQ_POT_PIN 7         // ADC7
+
+// Control slots - position in the scanner channel list, shared with the Java side
+#define CONTROL_SEEK 0
+#define CONTROL_VOLUME 1
+#define CONTROL_BPM 2
+#define CONTROL_CROSSFADE 3
+#define CONTROL_EQ 4
+
+#define ADC_SCAN_MAX_CHANNELS 8
+
+// Seek pot behaviour
+#define POT_MODE_RELATIVE 0  // SEEK_FWD/SEEK_BWD steps when the pot moves
+#define POT_MODE_SCRUB 1     // Pot position is the absolute track position
+
+#define SCRUB_HYSTERESIS 4   // Permille the pot must move before a new position is sent
+#define SCRUB_MAX_RATE 10    // Maximum absolute seek updates per second
+
+/**
+ * Configuration of one scanned ADC channel
+ */
+typedef struct {
+    uint8_t channel;       // ADC mux channel
+    uint8_t filter_shift;  // Low-pass strength (0-6): value += (sample - value) >> filter_shift
+    uint8_t threshold;     // Minimum change in counts before the slot is reported
+} AdcScanChannel;
+
 /**
  * Initialize the ADC for potentiometer reading
  */
@@ -25,19 +57,48 @@ void potentiometer_init(void);
 uint16_t read_adc(uint8_t channel);
 
 /**
- * Map a value from one range to another
- * @param x The value to map
- * @param in_min The minimum of the input range
- * @param in_max The maximum of the input range
- * @param out_min The minimum of the output range
- * @param out_max The maximum of the output range
- * @return The mapped value
+ * Start round-robin scanning of a list of ADC channels
+ * The list is not copied and must stay valid while scanning
+ * @param channels Array of channel configurations, index = control slot
+ * @param count Number of channels in the array (max ADC_SCAN_MAX_CHANNELS)
+ */
+void adc_scan_init(const AdcScanChannel* channels, uint8_t count);
+
+/**
+ * Advance the scanner by at most one conversion (non-blocking)
+ * Collects a finished conversion, filters it and starts the next channel
  */
-int32_t map_value(int32_t x, int32_t in_min, int32_t in_max, int32_t out_min, int32_t out_max);
+void adc_scan_update(void);
+
+/**
+ * Get the filtered value of a scanned slot
+ * @param slot Control slot (index in the channel list)
+ * @return Filtered ADC value (0-1023)
+ */
+uint16_t adc_scan_value(uint8_t slot);
+
+/**
+ * Collect the slots that moved past their threshold since their last report
+ * The returned slots are marked as reported
+ * @param mask Slots to consider (bit n = slot n)
+ * @return Bitmask of changed slots
+ */
+uint8_t adc_scan_changed(uint8_t mask);
+
+/**
+ * Select how the seek pot is interpreted
+ * @param mode POT_MODE_RELATIVE or POT_MODE_SCRUB
+ */
+void potentiometer_set_mode(uint8_t mode);
 
 /**
  * Check potentiometer position and handle seek
  */
 void potentiometer_check(void);
 
-#endif
\ No newline at end of file
+/**
+ * Scan all control pots and send one aggregated report for the ones that changed
+ */
+void controls_check(void);
+
+#endif
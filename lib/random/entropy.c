@@ -0,0 +1,122 @@
+/**
+ * @file entropy.c
+ * @brief Implementation of the hardware entropy pool
+ */
+
+ #if defined(__AVR__)
+ 
+ #include "entropy.h"
+ #include <avr/io.h>
+ 
+ #define POOL_WORDS 4
+ #define NO_PENDING_BIT 0xFF
+ 
+ static uint32_t pool[POOL_WORDS];
+ static uint8_t poolIndex = 0;
+ static uint16_t poolBits = 0;
+ 
+ /* Von Neumann extractor state */
+ static uint8_t pendingBit = NO_PENDING_BIT;
+ static uint8_t collectedByte = 0;
+ static uint8_t collectedCount = 0;
+ 
+ /**
+  * Stir one byte into the pool
+  * xorshift32 spreads the byte over the word, adding the next word
+  * keeps a word from collapsing to zero
+  */
+ static void pool_mix(uint8_t value) {
+     uint32_t x = pool[poolIndex] ^ value;
+     x ^= x << 13;
+     x ^= x >> 17;
+     x ^= x << 5;
+     
+     uint8_t next = (poolIndex + 1) & (POOL_WORDS - 1);
+     pool[poolIndex] = x + pool[next] + 0x9E3779B9;
+     poolIndex = next;
+ }
+ 
+ /**
+  * Feed one raw bit through the von Neumann extractor
+  * Pairs 01 and 10 yield a bit, 00 and 11 are dropped, which removes bias
+  */
+ static void pool_add_bit(uint8_t bit) {
+     if (pendingBit == NO_PENDING_BIT) {
+         pendingBit = bit;
+         return;
+     }
+     
+     if (pendingBit != bit) {
+         collectedByte = (collectedByte << 1) | pendingBit;
+         collectedCount++;
+         
+         if (collectedCount == 8) {
+             pool_mix(collectedByte);
+             poolBits += 8;
+             collectedCount = 0;
+         }
+     }
+     
+     pendingBit = NO_PENDING_BIT;
+ }
+ 
+ /* SplitMix64 finalizer, turns pool words into well-spread seeds */
+ static uint64_t mix64(uint64_t z) {
+     z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9;
+     z = (z ^ (z >> 27)) * 0x94D049BB133111EB;
+     return z ^ (z >> 31);
+ }
+ 
+ void entropy_collect(uint16_t samples) {
+     uint8_t savedMux = ADMUX;
+     uint8_t savedControl = ADCSRA;
+     
+     /* AVcc reference, bandgap input, prescaler 16: the fast clock adds noise */
+     ADMUX = (1 << REFS0) | ENTROPY_ADC_CHANNEL;
+     ADCSRA = (1 << ADEN) | (1 << ADPS2);
+     
+     for (uint16_t i = 0; i < samples; i++) {
+         ADCSRA |= (1 << ADSC);
+         while (ADCSRA & (1 << ADSC));
+         
+         uint16_t sample = ADC;
+         pool_add_bit(sample & 1);
+         
+         /* Timer phase at conversion end carries interrupt and clock jitter */
+         pool_mix((uint8_t)TCNT1 ^ TCNT0);
+     }
+     
+     ADMUX = savedMux;
+     ADCSRA = savedControl;
+ }
+ 
+ void entropy_add(uint16_t value) {
+     pool_mix(value & 0xFF);
+     pool_mix(value >> 8);
+ }
+ 
+ uint16_t entropy_available(void) {
+     return poolBits;
+ }
+ 
+ void entropy_seed(random_state_t *state) {
+     uint16_t taken = 0;
+     
+     while (poolBits < ENTROPY_SEED_BITS && taken < ENTROPY_MAX_SAMPLES) {
+         entropy_collect(256);
+         taken += 256;
+     }
+     
+     uint64_t seeds[POOL_WORDS];
+     for (uint8_t i = 0; i < POOL_WORDS; i++) {
+         uint64_t word = ((uint64_t)pool[i] << 32) | pool[(i + 1) & (POOL_WORDS - 1)];
+         seeds[i] = mix64(word + (i + 1) * 0x9E3779B97F4A7C15);
+     }
+     
+     random_init_with_seeds(state, seeds[0], seeds[1], seeds[2], seeds[3]);
+     
+     /* Bits are spent once they seeded a generator */
+     poolBits = 0;
+ }
+ 
+ #endif /* __AVR__ */
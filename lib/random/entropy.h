@@ -0,0 +1,61 @@
+/**
+ * @file entropy.h
+ * @brief Hardware entropy pool for seeding the random number generator on AVR
+ * 
+ * Collects ADC noise from the internal bandgap channel and timer jitter,
+ * whitens it and uses it to seed a random_state_t.
+ */
+
+ #ifndef ENTROPY_H
+ #define ENTROPY_H
+ 
+ #include <stdint.h>
+ #include "random.h"
+ 
+ /* Internal 1.1V bandgap reference, no pin needed */
+ #define ENTROPY_ADC_CHANNEL 14
+ 
+ /* Debiased bits required before the pool is used as a seed */
+ #define ENTROPY_SEED_BITS 128
+ 
+ /* Upper bound on ADC samples taken by one entropy_seed() call */
+ #define ENTROPY_MAX_SAMPLES 8192
+ 
+ /**
+  * @brief Sample the ADC noise source and mix the results into the pool
+  * 
+  * The ADC configuration is saved and restored, so this can be called
+  * between regular potentiometer reads.
+  * 
+  * @param samples Number of ADC conversions to take
+  */
+ void entropy_collect(uint16_t samples);
+ 
+ /**
+  * @brief Mix an external event value into the pool
+  * 
+  * Useful for values with human timing in them, like a counter sampled
+  * at a button press. These are not credited as entropy bits.
+  * 
+  * @param value The value to mix in
+  */
+ void entropy_add(uint16_t value);
+ 
+ /**
+  * @brief Get the number of whitened bits collected since the last seed
+  * 
+  * @return Number of debiased bits in the pool
+  */
+ uint16_t entropy_available(void);
+ 
+ /**
+  * @brief Seed a random state from the pool
+  * 
+  * Collects more samples first if fewer than ENTROPY_SEED_BITS bits are
+  * available, then seeds through random_init_with_seeds().
+  * 
+  * @param state Pointer to random state structure
+  */
+ void entropy_seed(random_state_t *state);
+ 
+ #endif /* ENTROPY_H */
@@ -7,9 +7,14 @@
  #include <stdlib.h>
  #include <stdbool.h>
  #include <string.h>
- #include <time.h>
  #include <math.h>
  
+ #if defined(__AVR__)
+ #include "entropy.h"
+ #else
+ #include <time.h>
+ #endif
+ 
  /* Global random state instance */
  random_state_t global_random_state = {{0, 0, 0, 0}, false};
  
@@ -25,8 +30,13 @@
  }
  
  void random_init(random_state_t *state) {
+ #if defined(__AVR__)
+     /* There is no wall clock on the AVR, seed from hardware noise instead */
+     entropy_seed(state);
+ #else
      uint64_t seed = (uint64_t)time(NULL);
      random_init_with_seed(state, seed);
+ #endif
  }
  
  void random_init_with_seed(random_state_t *state, uint64_t seed) {
@@ -75,6 +85,70 @@
      return (uint32_t)(random_uint64(state) >> 32);
  }
  
+ uint32_t random_bounded32(random_state_t *state, uint32_t range) {
+     uint32_t x = random_uint32(state);
+     
+     if (range == 0) {
+         return x;
+     }
+     
+     uint64_t m = (uint64_t)x * range;
+     uint32_t low = (uint32_t)m;
+     
+     /* Only low products can be biased, the threshold costs a division then */
+     if (low < range) {
+         uint32_t threshold = -range % range;
+         
+         while (low < threshold) {
+             x = random_uint32(state);
+             m = (uint64_t)x * range;
+             low = (uint32_t)m;
+         }
+     }
+     
+     return (uint32_t)(m >> 32);
+ }
+ 
+ /* Full 128-bit product of two 64-bit values */
+ static inline void multiply64(uint64_t a, uint64_t b, uint64_t *high, uint64_t *low) {
+ #if defined(__SIZEOF_INT128__)
+     unsigned __int128 m = (unsigned __int128)a * b;
+     *high = (uint64_t)(m >> 64);
+     *low = (uint64_t)m;
+ #else
+     uint64_t a_lo = (uint32_t)a, a_hi = a >> 32;
+     uint64_t b_lo = (uint32_t)b, b_hi = b >> 32;
+     uint64_t lo_lo = a_lo * b_lo;
+     uint64_t hi_lo = a_hi * b_lo;
+     uint64_t lo_hi = a_lo * b_hi;
+     uint64_t cross = (lo_lo >> 32) + (uint32_t)hi_lo + lo_hi;
+     *high = a_hi * b_hi + (hi_lo >> 32) + (cross >> 32);
+     *low = (cross << 32) | (uint32_t)lo_lo;
+ #endif
+ }
+ 
+ uint64_t random_bounded64(random_state_t *state, uint64_t range) {
+     uint64_t x = random_uint64(state);
+     uint64_t high, low;
+     
+     if (range == 0) {
+         return x;
+     }
+     
+     multiply64(x, range, &high, &low);
+     
+     if (low < range) {
+         uint64_t threshold = -range % range;
+         
+         while (low < threshold) {
+             x = random_uint64(state);
+             multiply64(x, range, &high, &low);
+         }
+     }
+     
+     return high;
+ }
+ 
  int random_int_range(random_state_t *state, int min, int max) {
      if (min > max) {
          int temp = min;
@@ -82,16 +156,11 @@
          max = temp;
      }
      
-     uint64_t range = (uint64_t)(max - min) + 1;
-     uint64_t scale = 0xFFFFFFFFFFFFFFFFULL / range;
-     uint64_t limit = range * scale;
-     uint64_t r;
-     
-     do {
-         r = random_uint64(state);
-     } while (r >= limit);
+     /* Unsigned arithmetic wraps correctly for any int width. The range
+        becomes 0 (2^32) for the full range of a 32-bit int */
+     uint32_t range = (uint32_t)((unsigned)max - (unsigned)min) + 1;
      
-     return min + (int)(r / scale);
+     return (int)((unsigned)min + (unsigned)random_bounded32(state, range));
  }
  
  float random_float(random_state_t *state) {
@@ -120,38 +189,14 @@
      return random_double(state) < probability;
  }
  
- /* Box-Muller transform for normal distribution */
+ /* Normal distribution from the standard Ziggurat sampler */
  static double normal_distribution(random_state_t *state, double mean, double stddev) {
-     static int has_spare = 0;
-     static double spare;
-     double u, v, s, norm;
-     
-     if (has_spare) {
-         has_spare = 0;
-         return mean + stddev * spare;
-     }
-     
-     do {
-         u = random_double(state) * 2.0 - 1.0;
-         v = random_double(state) * 2.0 - 1.0;
-         s = u * u + v * v;
-     } while (s >= 1.0 || s == 0.0);
-     
-     s = sqrt(-2.0 * log(s) / s);
-     spare = v * s;
-     has_spare = 1;
-     
-     return mean + stddev * u * s;
+     return mean + stddev * random_normal(state);
  }
  
- /* Exponential distribution using inverse transform sampling */
+ /* Exponential distribution from the Ziggurat sampler with rate 1 */
  static double exponential_distribution(random_state_t *state, double lambda) {
-     double u;
-     do {
-         u = random_double(state);
-     } while (u == 0.0);
-     
-     return -log(u) / lambda;
+     return random_exponential(state) / lambda;
  }
  
  /* Poisson distribution using Knuth's algorithm */
@@ -209,7 +254,9 @@
      if (!temp) return;
      
      for (size_t i = array_length - 1; i > 0; i--) {
-         size_t j = random_int_range(state, 0, i);
+         size_t j = (sizeof(size_t) <= sizeof(uint32_t))
+             ? (size_t)random_bounded32(state, (uint32_t)i + 1)
+             : (size_t)random_bounded64(state, (uint64_t)i + 1);
          
          if (i != j) {
              /* Swap elements i and j */
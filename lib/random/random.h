@@ -33,6 +33,7 @@
  
  /**
   * @brief Initialize a random state with system time as seed
+  * On AVR targets the seed comes from the hardware entropy pool (entropy.h)
   * 
   * @param state Pointer to random state structure
   */
@@ -74,8 +75,30 @@
   */
  uint32_t random_uint32(random_state_t *state);
  
+ /**
+  * @brief Get a random 32-bit integer in [0, range)
+  * Lemire's multiply-shift with rejection: one multiply and no division
+  * in the common case, and exactly uniform
+  * 
+  * @param state Pointer to random state structure
+  * @param range Number of possible values, 0 means 2^32
+  * @return A random integer below range
+  */
+ uint32_t random_bounded32(random_state_t *state, uint32_t range);
+ 
+ /**
+  * @brief Get a random 64-bit integer in [0, range)
+  * Same method as random_bounded32() with a 128-bit product
+  * 
+  * @param state Pointer to random state structure
+  * @param range Number of possible values, 0 means 2^64
+  * @return A random integer below range
+  */
+ uint64_t random_bounded64(random_state_t *state, uint64_t range);
+ 
  /**
   * @brief Get a random integer within a specified range [min, max]
+  * Uses random_bounded32()
   * 
   * @param state Pointer to random state structure
   * @param min Minimum value (inclusive)
@@ -137,6 +160,24 @@
   */
  bool random_bool_prob(random_state_t *state, double probability);
  
+ /**
+  * @brief Get a standard normal random number (mean 0, standard deviation 1)
+  * Ziggurat method (ziggurat.c), reentrant: no state outside random_state_t
+  * 
+  * @param state Pointer to random state structure
+  * @return A normally distributed double
+  */
+ double random_normal(random_state_t *state);
+ 
+ /**
+  * @brief Get an exponential random number with rate 1
+  * Ziggurat method (ziggurat.c), reentrant: no state outside random_state_t
+  * 
+  * @param state Pointer to random state structure
+  * @return An exponentially distributed double, mean 1
+  */
+ double random_exponential(random_state_t *state);
+ 
  /**
   * @brief Get a random number from a specified distribution
   * 
@@ -202,6 +243,7 @@
  /**
   * @brief Global initialization function
   * This initializes the global random state with system time
+  * (hardware entropy on AVR)
   */
  void random_global_init(void);
  
@@ -0,0 +1,374 @@
+/**
+ * @file ziggurat.c
+ * @brief Ziggurat samplers for the normal and exponential distributions
+ * 
+ * Marsaglia and Tsang's method: a sample picks one of 128 (normal) or 256
+ * (exponential) layers of equal area under the density. Inside a layer's
+ * rectangle the sample is accepted with one multiply and one table
+ * compare, which covers about 99% of the samples. Only the rest uses
+ * exp() or log(). The layer index and the value come from separate bits
+ * of one 32-bit random number, so they are independent.
+ */
+
+ #include "random.h"
+ #include <math.h>
+ 
+ #if defined(__AVR__)
+ /* The tables take 4.5 KB, they stay in flash */
+ #include <avr/pgmspace.h>
+ #define ZIGGURAT_TABLE PROGMEM
+ #define table_u32(table, i) pgm_read_dword(&(table)[i])
+ #define table_float(table, i) pgm_read_float(&(table)[i])
+ #else
+ #define ZIGGURAT_TABLE
+ #define table_u32(table, i) ((table)[i])
+ #define table_float(table, i) ((table)[i])
+ #endif
+ 
+ /* Start of the normal tail and of the exponential tail */
+ #define NORMAL_R 3.442619855899
+ #define EXPONENTIAL_R 7.697117470131487
+ 
+ /*
+  * Tables for values scaled to 24 bits, from Marsaglia and Tsang's zigset()
+  * with m1 = m2 = 2^24: for layer i, K is the limit below which a sample
+  * is inside the rectangle, W converts a sample to x and F is the density
+  * at the layer's edge. Normal: r = 3.442619855899, v = 9.91256303526217e-3.
+  * Exponential: r = 7.697117470131487, v = 3.949659822581572e-3.
+  */
+ static const uint32_t KN[128] ZIGGURAT_TABLE = {
+     0xed5a44UL, 0x000000UL, 0xc01e36UL, 0xd9c88fUL, 0xe4b68dUL, 0xeac00aUL,
+     0xee9243UL, 0xf1344bUL, 0xf3208bUL, 0xf4979cUL, 0xf5bec5UL, 0xf6ad05UL,
+     0xf77151UL, 0xf815ceUL, 0xf8a199UL, 0xf919d8UL, 0xf98259UL, 0xf9ddfdUL,
+     0xfa2efcUL, 0xfa7711UL, 0xfab79cUL, 0xfaf1baUL, 0xfb2651UL, 0xfb561cUL,
+     0xfb81baUL, 0xfba9adUL, 0xfbce63UL, 0xfbf039UL, 0xfc0f81UL, 0xfc2c7dUL,
+     0xfc476bUL, 0xfc607bUL, 0xfc77ddUL, 0xfc8db6UL, 0xfca22aUL, 0xfcb557UL,
+     0xfcc757UL, 0xfcd844UL, 0xfce832UL, 0xfcf734UL, 0xfd055bUL, 0xfd12b8UL,
+     0xfd1f58UL, 0xfd2b47UL, 0xfd3692UL, 0xfd4141UL, 0xfd4b60UL, 0xfd54f5UL,
+     0xfd5e09UL, 0xfd66a4UL, 0xfd6ecbUL, 0xfd7684UL, 0xfd7dd5UL, 0xfd84c4UL,
+     0xfd8b53UL, 0xfd9188UL, 0xfd9766UL, 0xfd9cf1UL, 0xfda22cUL, 0xfda71aUL,
+     0xfdabbeUL, 0xfdb019UL, 0xfdb42eUL, 0xfdb800UL, 0xfdbb8fUL, 0xfdbeddUL,
+     0xfdc1ecUL, 0xfdc4bdUL, 0xfdc751UL, 0xfdc9a8UL, 0xfdcbc4UL, 0xfdcda5UL,
+     0xfdcf4cUL, 0xfdd0b8UL, 0xfdd1e9UL, 0xfdd2e0UL, 0xfdd39cUL, 0xfdd41dUL,
+     0xfdd462UL, 0xfdd46aUL, 0xfdd435UL, 0xfdd3c0UL, 0xfdd30cUL, 0xfdd215UL,
+     0xfdd0daUL, 0xfdcf58UL, 0xfdcd8eUL, 0xfdcb79UL, 0xfdc914UL, 0xfdc65dUL,
+     0xfdc350UL, 0xfdbfe8UL, 0xfdbc1fUL, 0xfdb7f1UL, 0xfdb357UL, 0xfdae49UL,
+     0xfda8bfUL, 0xfda2b0UL, 0xfd9c12UL, 0xfd94d9UL, 0xfd8cf7UL, 0xfd845dUL,
+     0xfd7afaUL, 0xfd70b8UL, 0xfd6580UL, 0xfd5938UL, 0xfd4bbeUL, 0xfd3cedUL,
+     0xfd2c98UL, 0xfd1a89UL, 0xfd0680UL, 0xfcf02eUL, 0xfcd732UL, 0xfcbb14UL,
+     0xfc9b3bUL, 0xfc76e6UL, 0xfc4d18UL, 0xfc1c7fUL, 0xfbe354UL, 0xfb9f18UL,
+     0xfb4c34UL, 0xfae541UL, 0xfa61c1UL, 0xf9b369UL, 0xf8c01eUL, 0xf75217UL,
+     0xf4e442UL, 0xefacc9UL
+ };
+
+ static const float WN[128] ZIGGURAT_TABLE = {
+     2.213171868e-07f, 1.623158841e-08f, 2.162882275e-08f, 2.542424121e-08f,
+     2.845751269e-08f, 3.103351824e-08f, 3.330064883e-08f, 3.534334555e-08f,
+     3.721467241e-08f, 3.895036213e-08f, 4.057573787e-08f, 4.210946627e-08f,
+     4.356574480e-08f, 4.495565083e-08f, 4.628801274e-08f, 4.756999377e-08f,
+     4.880749623e-08f, 5.000544872e-08f, 5.116801519e-08f, 5.229875023e-08f,
+     5.340071634e-08f, 5.447657412e-08f, 5.552865247e-08f, 5.655900392e-08f,
+     5.756944891e-08f, 5.856161139e-08f, 5.953694782e-08f, 6.049677105e-08f,
+     6.144227004e-08f, 6.237452631e-08f, 6.329452775e-08f, 6.420318037e-08f,
+     6.510131818e-08f, 6.598971173e-08f, 6.686907545e-08f, 6.774007392e-08f,
+     6.860332740e-08f, 6.945941664e-08f, 7.030888704e-08f, 7.115225243e-08f,
+     7.198999825e-08f, 7.282258454e-08f, 7.365044852e-08f, 7.447400687e-08f,
+     7.529365787e-08f, 7.610978327e-08f, 7.692274999e-08f, 7.773291171e-08f,
+     7.854061027e-08f, 7.934617696e-08f, 8.014993380e-08f, 8.095219459e-08f,
+     8.175326600e-08f, 8.255344854e-08f, 8.335303748e-08f, 8.415232375e-08f,
+     8.495159474e-08f, 8.575113515e-08f, 8.655122774e-08f, 8.735215410e-08f,
+     8.815419537e-08f, 8.895763301e-08f, 8.976274948e-08f, 9.056982903e-08f,
+     9.137915836e-08f, 9.219102739e-08f, 9.300573005e-08f, 9.382356501e-08f,
+     9.464483648e-08f, 9.546985508e-08f, 9.629893869e-08f, 9.713241336e-08f,
+     9.797061425e-08f, 9.881388670e-08f, 9.966258729e-08f, 1.005170850e-07f,
+     1.013777625e-07f, 1.022450173e-07f, 1.031192637e-07f, 1.040009337e-07f,
+     1.048904791e-07f, 1.057883737e-07f, 1.066951145e-07f, 1.076112249e-07f,
+     1.085372565e-07f, 1.094737923e-07f, 1.104214496e-07f, 1.113808835e-07f,
+     1.123527906e-07f, 1.133379133e-07f, 1.143370450e-07f, 1.153510349e-07f,
+     1.163807946e-07f, 1.174273050e-07f, 1.184916242e-07f, 1.195748967e-07f,
+     1.206783636e-07f, 1.218033753e-07f, 1.229514047e-07f, 1.241240643e-07f,
+     1.253231248e-07f, 1.265505379e-07f, 1.278084625e-07f, 1.290992972e-07f,
+     1.304257174e-07f, 1.317907219e-07f, 1.331976888e-07f, 1.346504434e-07f,
+     1.361533439e-07f, 1.377113869e-07f, 1.393303419e-07f, 1.410169226e-07f,
+     1.427790092e-07f, 1.446259407e-07f, 1.465689050e-07f, 1.486214711e-07f,
+     1.508003278e-07f, 1.531263367e-07f, 1.556260734e-07f, 1.583341605e-07f,
+     1.612969382e-07f, 1.645785196e-07f, 1.682713837e-07f, 1.725163464e-07f,
+     1.775441320e-07f, 1.837747609e-07f, 1.921108356e-07f, 2.051961336e-07f
+ };
+
+ static const float FN[128] ZIGGURAT_TABLE = {
+     1.000000000e+00f, 9.635996931e-01f, 9.362826817e-01f, 9.130436480e-01f,
+     8.922816508e-01f, 8.732430489e-01f, 8.555006079e-01f, 8.387836053e-01f,
+     8.229072114e-01f, 8.077382947e-01f, 7.931770118e-01f, 7.791460859e-01f,
+     7.655841739e-01f, 7.524415592e-01f, 7.396772437e-01f, 7.272569183e-01f,
+     7.151515074e-01f, 7.033360990e-01f, 6.917891434e-01f, 6.804918410e-01f,
+     6.694276673e-01f, 6.585820001e-01f, 6.479418211e-01f, 6.374954773e-01f,
+     6.272324852e-01f, 6.171433708e-01f, 6.072195366e-01f, 5.974531509e-01f,
+     5.878370544e-01f, 5.783646811e-01f, 5.690299911e-01f, 5.598274127e-01f,
+     5.507517931e-01f, 5.417983550e-01f, 5.329626594e-01f, 5.242405727e-01f,
+     5.156282382e-01f, 5.071220511e-01f, 4.987186355e-01f, 4.904148253e-01f,
+     4.822076463e-01f, 4.740943007e-01f, 4.660721527e-01f, 4.581387163e-01f,
+     4.502916437e-01f, 4.425287153e-01f, 4.348478302e-01f, 4.272469983e-01f,
+     4.197243320e-01f, 4.122780401e-01f, 4.049064208e-01f, 3.976078565e-01f,
+     3.903808082e-01f, 3.832238111e-01f, 3.761354695e-01f, 3.691144537e-01f,
+     3.621594954e-01f, 3.552693848e-01f, 3.484429675e-01f, 3.416791412e-01f,
+     3.349768533e-01f, 3.283350984e-01f, 3.217529159e-01f, 3.152293881e-01f,
+     3.087636380e-01f, 3.023548278e-01f, 2.960021568e-01f, 2.897048604e-01f,
+     2.834622082e-01f, 2.772735029e-01f, 2.711380791e-01f, 2.650553023e-01f,
+     2.590245674e-01f, 2.530452985e-01f, 2.471169475e-01f, 2.412389935e-01f,
+     2.354109423e-01f, 2.296323252e-01f, 2.239026994e-01f, 2.182216466e-01f,
+     2.125887731e-01f, 2.070037094e-01f, 2.014661101e-01f, 1.959756531e-01f,
+     1.905320403e-01f, 1.851349970e-01f, 1.797842721e-01f, 1.744796383e-01f,
+     1.692208922e-01f, 1.640078547e-01f, 1.588403711e-01f, 1.537183122e-01f,
+     1.486415742e-01f, 1.436100801e-01f, 1.386237800e-01f, 1.336826526e-01f,
+     1.287867062e-01f, 1.239359802e-01f, 1.191305467e-01f, 1.143705124e-01f,
+     1.096560210e-01f, 1.049872554e-01f, 1.003644410e-01f, 9.578784912e-02f,
+     9.125780083e-02f, 8.677467189e-02f, 8.233889824e-02f, 7.795098251e-02f,
+     7.361150188e-02f, 6.932111739e-02f, 6.508058521e-02f, 6.089077035e-02f,
+     5.675266348e-02f, 5.266740190e-02f, 4.863629586e-02f, 4.466086220e-02f,
+     4.074286807e-02f, 3.688438879e-02f, 3.308788615e-02f, 2.935631744e-02f,
+     2.569329194e-02f, 2.210330462e-02f, 1.859210274e-02f, 1.516729801e-02f,
+     1.183947866e-02f, 8.624484413e-03f, 5.548995221e-03f, 2.669629084e-03f
+ };
+
+ static const uint32_t KE[256] ZIGGURAT_TABLE = {
+     0xe290a1UL, 0x000000UL, 0x9beadeUL, 0xc377acUL, 0xd4ddb9UL, 0xde893fUL,
+     0xe4a8e8UL, 0xe8dff1UL, 0xebf2deUL, 0xee49a6UL, 0xf0204eUL, 0xf19bdbUL,
+     0xf2d458UL, 0xf3da10UL, 0xf4b86dUL, 0xf577adUL, 0xf61de8UL, 0xf6afb7UL,
+     0xf730a5UL, 0xf7a376UL, 0xf80a5bUL, 0xf86718UL, 0xf8bb1bUL, 0xf90790UL,
+     0xf94d70UL, 0xf98d8cUL, 0xf9c892UL, 0xf9ff17UL, 0xfa3199UL, 0xfa6085UL,
+     0xfa8c3aUL, 0xfab508UL, 0xfadb36UL, 0xfaff04UL, 0xfb20a6UL, 0xfb404fUL,
+     0xfb5e29UL, 0xfb7a59UL, 0xfb9503UL, 0xfbae44UL, 0xfbc638UL, 0xfbdcf8UL,
+     0xfbf29aUL, 0xfc0731UL, 0xfc1ad1UL, 0xfc2d8bUL, 0xfc3f6cUL, 0xfc5083UL,
+     0xfc60ddUL, 0xfc7086UL, 0xfc7f88UL, 0xfc8decUL, 0xfc9bbdUL, 0xfca902UL,
+     0xfcb5c3UL, 0xfcc208UL, 0xfccdd7UL, 0xfcd935UL, 0xfce42aUL, 0xfceebaUL,
+     0xfcf8ebUL, 0xfd02c0UL, 0xfd0c3fUL, 0xfd156bUL, 0xfd1e48UL, 0xfd26daUL,
+     0xfd2f25UL, 0xfd372aUL, 0xfd3eeeUL, 0xfd4673UL, 0xfd4dbcUL, 0xfd54cbUL,
+     0xfd5ba2UL, 0xfd6245UL, 0xfd68b4UL, 0xfd6ef1UL, 0xfd7500UL, 0xfd7ae1UL,
+     0xfd8096UL, 0xfd8620UL, 0xfd8b82UL, 0xfd90bcUL, 0xfd95d1UL, 0xfd9ac1UL,
+     0xfd9f8dUL, 0xfda437UL, 0xfda8bfUL, 0xfdad28UL, 0xfdb171UL, 0xfdb59cUL,
+     0xfdb9a9UL, 0xfdbd9bUL, 0xfdc170UL, 0xfdc52bUL, 0xfdc8ccUL, 0xfdcc54UL,
+     0xfdcfc3UL, 0xfdd319UL, 0xfdd659UL, 0xfdd982UL, 0xfddc94UL, 0xfddf91UL,
+     0xfde279UL, 0xfde54dUL, 0xfde80cUL, 0xfdeab7UL, 0xfded50UL, 0xfdefd5UL,
+     0xfdf248UL, 0xfdf4aaUL, 0xfdf6f9UL, 0xfdf937UL, 0xfdfb64UL, 0xfdfd81UL,
+     0xfdff8dUL, 0xfe018aUL, 0xfe0376UL, 0xfe0553UL, 0xfe0721UL, 0xfe08dfUL,
+     0xfe0a8fUL, 0xfe0c30UL, 0xfe0dc3UL, 0xfe0f48UL, 0xfe10bfUL, 0xfe1228UL,
+     0xfe1383UL, 0xfe14d1UL, 0xfe1611UL, 0xfe1745UL, 0xfe186bUL, 0xfe1984UL,
+     0xfe1a90UL, 0xfe1b8fUL, 0xfe1c82UL, 0xfe1d68UL, 0xfe1e42UL, 0xfe1f0fUL,
+     0xfe1fcfUL, 0xfe2083UL, 0xfe212bUL, 0xfe21c7UL, 0xfe2256UL, 0xfe22d9UL,
+     0xfe234fUL, 0xfe23baUL, 0xfe2418UL, 0xfe2469UL, 0xfe24afUL, 0xfe24e8UL,
+     0xfe2514UL, 0xfe2534UL, 0xfe2547UL, 0xfe254eUL, 0xfe2548UL, 0xfe2535UL,
+     0xfe2515UL, 0xfe24e8UL, 0xfe24aeUL, 0xfe2466UL, 0xfe2411UL, 0xfe23afUL,
+     0xfe233eUL, 0xfe22c0UL, 0xfe2233UL, 0xfe2198UL, 0xfe20eeUL, 0xfe2035UL,
+     0xfe1f6dUL, 0xfe1e96UL, 0xfe1daeUL, 0xfe1cb7UL, 0xfe1bb0UL, 0xfe1a97UL,
+     0xfe196eUL, 0xfe1832UL, 0xfe16e5UL, 0xfe1586UL, 0xfe1414UL, 0xfe128eUL,
+     0xfe10f5UL, 0xfe0f47UL, 0xfe0d84UL, 0xfe0bacUL, 0xfe09bdUL, 0xfe07b7UL,
+     0xfe059aUL, 0xfe0364UL, 0xfe0115UL, 0xfdfeabUL, 0xfdfc26UL, 0xfdf986UL,
+     0xfdf6c8UL, 0xfdf3ecUL, 0xfdf0f0UL, 0xfdedd3UL, 0xfdea95UL, 0xfde733UL,
+     0xfde3abUL, 0xfddffdUL, 0xfddc27UL, 0xfdd826UL, 0xfdd3f9UL, 0xfdcf9dUL,
+     0xfdcb11UL, 0xfdc651UL, 0xfdc15bUL, 0xfdbc2cUL, 0xfdb6c2UL, 0xfdb117UL,
+     0xfdab2aUL, 0xfda4f5UL, 0xfd9e76UL, 0xfd97a6UL, 0xfd9081UL, 0xfd8901UL,
+     0xfd8121UL, 0xfd78d9UL, 0xfd7022UL, 0xfd66f4UL, 0xfd5d47UL, 0xfd530fUL,
+     0xfd4843UL, 0xfd3cd5UL, 0xfd30b9UL, 0xfd23deUL, 0xfd1634UL, 0xfd07a7UL,
+     0xfcf821UL, 0xfce789UL, 0xfcd5c2UL, 0xfcc2aaUL, 0xfcae1dUL, 0xfc97edUL,
+     0xfc7fe6UL, 0xfc65ccUL, 0xfc4957UL, 0xfc2a2fUL, 0xfc07eeUL, 0xfbe213UL,
+     0xfbb805UL, 0xfb8900UL, 0xfb5411UL, 0xfb1800UL, 0xfad334UL, 0xfa8392UL,
+     0xfa263bUL, 0xf9b72dUL, 0xf930a1UL, 0xf889f0UL, 0xf7b577UL, 0xf69c65UL,
+     0xf51530UL, 0xf2cb0eUL, 0xeeefb1UL, 0xe6da6eUL
+ };
+
+ static const float WE[256] ZIGGURAT_TABLE = {
+     5.183885974e-07f, 3.805885542e-09f, 6.248862002e-09f, 8.184014615e-09f,
+     9.842373286e-09f, 1.132242022e-08f, 1.267620985e-08f, 1.393499869e-08f,
+     1.511921664e-08f, 1.624305162e-08f, 1.731681558e-08f, 1.834827391e-08f,
+     1.934344274e-08f, 2.030709273e-08f, 2.124308111e-08f, 2.215457829e-08f,
+     2.304422724e-08f, 2.391425841e-08f, 2.476657448e-08f, 2.560281397e-08f,
+     2.642439998e-08f, 2.723257786e-08f, 2.802844495e-08f, 2.881297419e-08f,
+     2.958703312e-08f, 3.035139933e-08f, 3.110677311e-08f, 3.185378797e-08f,
+     3.259301932e-08f, 3.332499179e-08f, 3.405018547e-08f, 3.476904111e-08f,
+     3.548196461e-08f, 3.618933091e-08f, 3.689148732e-08f, 3.758875638e-08f,
+     3.828143838e-08f, 3.896981358e-08f, 3.965414413e-08f, 4.033467579e-08f,
+     4.101163940e-08f, 4.168525226e-08f, 4.235571926e-08f, 4.302323403e-08f,
+     4.368797979e-08f, 4.435013029e-08f, 4.500985051e-08f, 4.566729741e-08f,
+     4.632262050e-08f, 4.697596245e-08f, 4.762745961e-08f, 4.827724243e-08f,
+     4.892543593e-08f, 4.957216011e-08f, 5.021753024e-08f, 5.086165725e-08f,
+     5.150464802e-08f, 5.214660563e-08f, 5.278762965e-08f, 5.342781637e-08f,
+     5.406725900e-08f, 5.470604790e-08f, 5.534427075e-08f, 5.598201275e-08f,
+     5.661935674e-08f, 5.725638340e-08f, 5.789317137e-08f, 5.852979738e-08f,
+     5.916633639e-08f, 5.980286169e-08f, 6.043944502e-08f, 6.107615668e-08f,
+     6.171306561e-08f, 6.235023951e-08f, 6.298774490e-08f, 6.362564722e-08f,
+     6.426401088e-08f, 6.490289938e-08f, 6.554237536e-08f, 6.618250064e-08f,
+     6.682333635e-08f, 6.746494290e-08f, 6.810738013e-08f, 6.875070731e-08f,
+     6.939498321e-08f, 7.004026617e-08f, 7.068661412e-08f, 7.133408464e-08f,
+     7.198273500e-08f, 7.263262225e-08f, 7.328380321e-08f, 7.393633451e-08f,
+     7.459027269e-08f, 7.524567420e-08f, 7.590259542e-08f, 7.656109275e-08f,
+     7.722122262e-08f, 7.788304153e-08f, 7.854660607e-08f, 7.921197302e-08f,
+     7.987919930e-08f, 8.054834206e-08f, 8.121945873e-08f, 8.189260699e-08f,
+     8.256784488e-08f, 8.324523079e-08f, 8.392482350e-08f, 8.460668223e-08f,
+     8.529086667e-08f, 8.597743702e-08f, 8.666645401e-08f, 8.735797895e-08f,
+     8.805207379e-08f, 8.874880108e-08f, 8.944822412e-08f, 9.015040689e-08f,
+     9.085541417e-08f, 9.156331152e-08f, 9.227416537e-08f, 9.298804304e-08f,
+     9.370501276e-08f, 9.442514375e-08f, 9.514850624e-08f, 9.587517153e-08f,
+     9.660521202e-08f, 9.733870128e-08f, 9.807571407e-08f, 9.881632641e-08f,
+     9.956061564e-08f, 1.003086604e-07f, 1.010605409e-07f, 1.018163387e-07f,
+     1.025761367e-07f, 1.033400199e-07f, 1.041080744e-07f, 1.048803884e-07f,
+     1.056570518e-07f, 1.064381561e-07f, 1.072237951e-07f, 1.080140643e-07f,
+     1.088090616e-07f, 1.096088867e-07f, 1.104136417e-07f, 1.112234311e-07f,
+     1.120383617e-07f, 1.128585430e-07f, 1.136840868e-07f, 1.145151079e-07f,
+     1.153517238e-07f, 1.161940550e-07f, 1.170422249e-07f, 1.178963602e-07f,
+     1.187565910e-07f, 1.196230506e-07f, 1.204958760e-07f, 1.213752079e-07f,
+     1.222611910e-07f, 1.231539738e-07f, 1.240537092e-07f, 1.249605543e-07f,
+     1.258746711e-07f, 1.267962260e-07f, 1.277253905e-07f, 1.286623414e-07f,
+     1.296072608e-07f, 1.305603365e-07f, 1.315217622e-07f, 1.324917378e-07f,
+     1.334704696e-07f, 1.344581708e-07f, 1.354550615e-07f, 1.364613694e-07f,
+     1.374773299e-07f, 1.385031864e-07f, 1.395391910e-07f, 1.405856048e-07f,
+     1.416426981e-07f, 1.427107513e-07f, 1.437900551e-07f, 1.448809111e-07f,
+     1.459836324e-07f, 1.470985443e-07f, 1.482259847e-07f, 1.493663051e-07f,
+     1.505198711e-07f, 1.516870634e-07f, 1.528682784e-07f, 1.540639293e-07f,
+     1.552744471e-07f, 1.565002815e-07f, 1.577419021e-07f, 1.589997995e-07f,
+     1.602744871e-07f, 1.615665016e-07f, 1.628764055e-07f, 1.642047880e-07f,
+     1.655522672e-07f, 1.669194919e-07f, 1.683071436e-07f, 1.697159389e-07f,
+     1.711466320e-07f, 1.726000171e-07f, 1.740769319e-07f, 1.755782601e-07f,
+     1.771049356e-07f, 1.786579460e-07f, 1.802383366e-07f, 1.818472157e-07f,
+     1.834857592e-07f, 1.851552166e-07f, 1.868569170e-07f, 1.885922765e-07f,
+     1.903628053e-07f, 1.921701172e-07f, 1.940159386e-07f, 1.959021194e-07f,
+     1.978306455e-07f, 1.998036522e-07f, 2.018234397e-07f, 2.038924907e-07f,
+     2.060134900e-07f, 2.081893477e-07f, 2.104232245e-07f, 2.127185622e-07f,
+     2.150791176e-07f, 2.175090024e-07f, 2.200127298e-07f, 2.225952681e-07f,
+     2.252621050e-07f, 2.280193221e-07f, 2.308736843e-07f, 2.338327468e-07f,
+     2.369049827e-07f, 2.400999394e-07f, 2.434284276e-07f, 2.469027558e-07f,
+     2.505370208e-07f, 2.543474722e-07f, 2.583529759e-07f, 2.625756081e-07f,
+     2.670414297e-07f, 2.717815078e-07f, 2.768332890e-07f, 2.822424767e-07f,
+     2.880656565e-07f, 2.943740538e-07f, 3.012590700e-07f, 3.088407088e-07f,
+     3.172809187e-07f, 3.268057482e-07f, 3.377443652e-07f, 3.506031225e-07f,
+     3.662207523e-07f, 3.861414488e-07f, 4.137178439e-07f, 4.587839526e-07f
+ };
+
+ static const float FE[256] ZIGGURAT_TABLE = {
+     1.000000000e+00f, 9.381436809e-01f, 9.004699299e-01f, 8.717043324e-01f,
+     8.477855006e-01f, 8.269932966e-01f, 8.084216515e-01f, 7.915276370e-01f,
+     7.759568520e-01f, 7.614633888e-01f, 7.478686220e-01f, 7.350380924e-01f,
+     7.228676596e-01f, 7.112747608e-01f, 7.001926551e-01f, 6.895664961e-01f,
+     6.793505723e-01f, 6.695063167e-01f, 6.600008411e-01f, 6.508058334e-01f,
+     6.418967164e-01f, 6.332519942e-01f, 6.248527387e-01f, 6.166821809e-01f,
+     6.087253821e-01f, 6.009689664e-01f, 5.934009017e-01f, 5.860103185e-01f,
+     5.787873586e-01f, 5.717230487e-01f, 5.648091929e-01f, 5.580382823e-01f,
+     5.514034165e-01f, 5.448982377e-01f, 5.385168720e-01f, 5.322538803e-01f,
+     5.261042140e-01f, 5.200631774e-01f, 5.141263938e-01f, 5.082897764e-01f,
+     5.025495018e-01f, 4.969019872e-01f, 4.913438696e-01f, 4.858719873e-01f,
+     4.804833639e-01f, 4.751751930e-01f, 4.699448253e-01f, 4.647897563e-01f,
+     4.597076156e-01f, 4.546961575e-01f, 4.497532512e-01f, 4.448768734e-01f,
+     4.400651008e-01f, 4.353161032e-01f, 4.306281373e-01f, 4.259995411e-01f,
+     4.214287290e-01f, 4.169141864e-01f, 4.124544660e-01f, 4.080481832e-01f,
+     4.036940125e-01f, 3.993906845e-01f, 3.951369818e-01f, 3.909317370e-01f,
+     3.867738291e-01f, 3.826621815e-01f, 3.785957594e-01f, 3.745735676e-01f,
+     3.705946484e-01f, 3.666580798e-01f, 3.627629734e-01f, 3.589084729e-01f,
+     3.550937529e-01f, 3.513180164e-01f, 3.475804946e-01f, 3.438804447e-01f,
+     3.402171491e-01f, 3.365899140e-01f, 3.329980688e-01f, 3.294409643e-01f,
+     3.259179724e-01f, 3.224284850e-01f, 3.189719128e-01f, 3.155476852e-01f,
+     3.121552488e-01f, 3.087940669e-01f, 3.054636192e-01f, 3.021634007e-01f,
+     2.988929210e-01f, 2.956517043e-01f, 2.924392882e-01f, 2.892552235e-01f,
+     2.860990737e-01f, 2.829704145e-01f, 2.798688332e-01f, 2.767939284e-01f,
+     2.737453097e-01f, 2.707225968e-01f, 2.677254199e-01f, 2.647534188e-01f,
+     2.618062427e-01f, 2.588835497e-01f, 2.559850070e-01f, 2.531102900e-01f,
+     2.502590824e-01f, 2.474310757e-01f, 2.446259691e-01f, 2.418434694e-01f,
+     2.390832903e-01f, 2.363451525e-01f, 2.336287834e-01f, 2.309339172e-01f,
+     2.282602939e-01f, 2.256076601e-01f, 2.229757681e-01f, 2.203643758e-01f,
+     2.177732471e-01f, 2.152021511e-01f, 2.126508620e-01f, 2.101191594e-01f,
+     2.076068277e-01f, 2.051136563e-01f, 2.026394391e-01f, 2.001839747e-01f,
+     1.977470661e-01f, 1.953285207e-01f, 1.929281500e-01f, 1.905457697e-01f,
+     1.881811994e-01f, 1.858342628e-01f, 1.835047871e-01f, 1.811926035e-01f,
+     1.788975466e-01f, 1.766194546e-01f, 1.743581692e-01f, 1.721135353e-01f,
+     1.698854013e-01f, 1.676736186e-01f, 1.654780419e-01f, 1.632985288e-01f,
+     1.611349399e-01f, 1.589871390e-01f, 1.568549924e-01f, 1.547383694e-01f,
+     1.526371420e-01f, 1.505511850e-01f, 1.484803756e-01f, 1.464245939e-01f,
+     1.443837222e-01f, 1.423576454e-01f, 1.403462511e-01f, 1.383494289e-01f,
+     1.363670709e-01f, 1.343990717e-01f, 1.324453279e-01f, 1.305057385e-01f,
+     1.285802045e-01f, 1.266686294e-01f, 1.247709186e-01f, 1.228869795e-01f,
+     1.210167218e-01f, 1.191600572e-01f, 1.173168992e-01f, 1.154871636e-01f,
+     1.136707679e-01f, 1.118676317e-01f, 1.100776764e-01f, 1.083008255e-01f,
+     1.065370041e-01f, 1.047861393e-01f, 1.030481602e-01f, 1.013229974e-01f,
+     9.961058367e-02f, 9.791085331e-02f, 9.622374255e-02f, 9.454918938e-02f,
+     9.288713356e-02f, 9.123751663e-02f, 8.960028191e-02f, 8.797537447e-02f,
+     8.636274114e-02f, 8.476233053e-02f, 8.317409301e-02f, 8.159798071e-02f,
+     8.003394754e-02f, 7.848194920e-02f, 7.694194317e-02f, 7.541388873e-02f,
+     7.389774699e-02f, 7.239348088e-02f, 7.090105516e-02f, 6.942043650e-02f,
+     6.795159342e-02f, 6.649449639e-02f, 6.504911779e-02f, 6.361543200e-02f,
+     6.219341541e-02f, 6.078304645e-02f, 5.938430563e-02f, 5.799717563e-02f,
+     5.662164128e-02f, 5.525768968e-02f, 5.390531020e-02f, 5.256449459e-02f,
+     5.123523706e-02f, 4.991753428e-02f, 4.861138557e-02f, 4.731679291e-02f,
+     4.603376108e-02f, 4.476229773e-02f, 4.350241357e-02f, 4.225412241e-02f,
+     4.101744138e-02f, 3.979239102e-02f, 3.857899550e-02f, 3.737728277e-02f,
+     3.618728478e-02f, 3.500903770e-02f, 3.384258215e-02f, 3.268796351e-02f,
+     3.154523217e-02f, 3.041444391e-02f, 2.929566022e-02f, 2.818894876e-02f,
+     2.709438378e-02f, 2.601204665e-02f, 2.494202642e-02f, 2.388442051e-02f,
+     2.283933541e-02f, 2.180688750e-02f, 2.078720407e-02f, 1.978042434e-02f,
+     1.878670074e-02f, 1.780620041e-02f, 1.683910683e-02f, 1.588562184e-02f,
+     1.494596801e-02f, 1.402039140e-02f, 1.310916493e-02f, 1.221259243e-02f,
+     1.133101360e-02f, 1.046481018e-02f, 9.614413643e-03f, 8.780314986e-03f,
+     7.963077438e-03f, 7.163353184e-03f, 6.381905937e-03f, 5.619642207e-03f,
+     4.877655984e-03f, 4.157295121e-03f, 3.460264778e-03f, 2.788798794e-03f,
+     2.145967744e-03f, 1.536299780e-03f, 9.672692823e-04f, 4.541343538e-04f
+ };
+
+ 
+ /* Uniform double in (0, 1], safe for log() */
+ static double random_positive_double(random_state_t *state) {
+     return 1.0 - random_double(state);
+ }
+ 
+ double random_normal(random_state_t *state) {
+     for (;;) {
+         uint32_t r = random_uint32(state);
+         uint8_t i = r & 127;
+         /* Signed 25-bit value from the bits above the layer index */
+         int32_t hz = (int32_t)r >> 7;
+         uint32_t magnitude = (hz < 0) ? -(uint32_t)hz : (uint32_t)hz;
+         double x = hz * (double)table_float(WN, i);
+         
+         if (magnitude < table_u32(KN, i)) {
+             return x;
+         }
+         
+         if (i == 0) {
+             /* Base layer: sample the tail beyond NORMAL_R */
+             double y;
+             do {
+                 x = -log(random_positive_double(state)) / NORMAL_R;
+                 y = -log(random_positive_double(state));
+             } while (y + y < x * x);
+             
+             return (hz > 0) ? NORMAL_R + x : -NORMAL_R - x;
+         }
+         
+         double f0 = table_float(FN, i);
+         double f1 = table_float(FN, i - 1);
+         if (f0 + random_double(state) * (f1 - f0) < exp(-0.5 * x * x)) {
+             return x;
+         }
+     }
+ }
+ 
+ double random_exponential(random_state_t *state) {
+     for (;;) {
+         uint32_t r = random_uint32(state);
+         uint8_t i = r & 255;
+         uint32_t jz = r >> 8;
+         double x = jz * (double)table_float(WE, i);
+         
+         if (jz < table_u32(KE, i)) {
+             return x;
+         }
+         
+         if (i == 0) {
+             /* Base layer: the tail is EXPONENTIAL_R plus a new exponential sample */
+             return EXPONENTIAL_R - log(random_positive_double(state));
+         }
+         
+         double f0 = table_float(FE, i);
+         double f1 = table_float(FE, i - 1);
+         if (f0 + random_double(state) * (f1 - f0) < exp(-x)) {
+             return x;
+         }
+     }
+ }
@@ -5,47 +5,243 @@
 #include "sound.h"
 #include <avr/interrupt.h>
 
+/*
+ * Note timing table, computed by the compiler for F_CPU
+ * Each entry holds the Timer2 compare value and clock select for half a
+ * period of the note, and how many output toggles fit in one millisecond
+ * as Q8.8, so a duration needs a multiply and a shift but no division.
+ * The 8-bit timer keeps every note within 0.6% (10 cents) of pitch.
+ */
+#define NOTE_HALF_CYCLES(mhz)   ((uint32_t)(((uint64_t)F_CPU * 500 + (mhz) / 2) / (mhz)))
+#define NOTE_TOP(mhz, shift)    ((NOTE_HALF_CYCLES(mhz) + (1UL << (shift)) / 2) >> (shift))
+#define NOTE_SHIFT(mhz)                     \
+    (NOTE_TOP(mhz, 0) <= 256 ? 0 :          \
+     NOTE_TOP(mhz, 3) <= 256 ? 3 :          \
+     NOTE_TOP(mhz, 5) <= 256 ? 5 :          \
+     NOTE_TOP(mhz, 6) <= 256 ? 6 :          \
+     NOTE_TOP(mhz, 7) <= 256 ? 7 :          \
+     NOTE_TOP(mhz, 8) <= 256 ? 8 : 10)
+#define NOTE_CLOCK_SELECT(shift)            \
+    ((shift) == 0 ? 1 : (shift) == 3 ? 2 : (shift) == 5 ? 3 : \
+     (shift) == 6 ? 4 : (shift) == 7 ? 5 : (shift) == 8 ? 6 : 7)
+#define NOTE_TOGGLES_Q8(top, shift) \
+    ((uint16_t)((F_CPU * 256 / 1000 + ((uint32_t)(top) << (shift)) / 2) / ((uint32_t)(top) << (shift))))
+#define NOTE_TIMING(mhz) {                                          \
+    NOTE_TOP(mhz, NOTE_SHIFT(mhz)) - 1,                             \
+    NOTE_CLOCK_SELECT(NOTE_SHIFT(mhz)),                             \
+    NOTE_TOGGLES_Q8(NOTE_TOP(mhz, NOTE_SHIFT(mhz)), NOTE_SHIFT(mhz)) }
+
+typedef struct {
+    uint8_t compare;          // OCR2A, half period in timer ticks minus one
+    uint8_t clock_select;     // TCCR2B prescaler bits
+    uint16_t toggles_per_ms;  // Output toggles per millisecond, Q8.8
+} NoteTiming;
+
+// MIDI notes NOTE_MIN-NOTE_MAX, frequencies in millihertz (A4 = 440 Hz)
+static const NoteTiming NOTE_TABLE[] PROGMEM = {
+    // Octave 2
+    NOTE_TIMING(65406), NOTE_TIMING(69296), NOTE_TIMING(73416), NOTE_TIMING(77782),
+    NOTE_TIMING(82407), NOTE_TIMING(87307), NOTE_TIMING(92499), NOTE_TIMING(97999),
+    NOTE_TIMING(103826), NOTE_TIMING(110000), NOTE_TIMING(116541), NOTE_TIMING(123471),
+    // Octave 3
+    NOTE_TIMING(130813), NOTE_TIMING(138591), NOTE_TIMING(146832), NOTE_TIMING(155563),
+    NOTE_TIMING(164814), NOTE_TIMING(174614), NOTE_TIMING(184997), NOTE_TIMING(195998),
+    NOTE_TIMING(207652), NOTE_TIMING(220000), NOTE_TIMING(233082), NOTE_TIMING(246942),
+    // Octave 4
+    NOTE_TIMING(261626), NOTE_TIMING(277183), NOTE_TIMING(293665), NOTE_TIMING(311127),
+    NOTE_TIMING(329628), NOTE_TIMING(349228), NOTE_TIMING(369994), NOTE_TIMING(391995),
+    NOTE_TIMING(415305), NOTE_TIMING(440000), NOTE_TIMING(466164), NOTE_TIMING(493883),
+    // Octave 5
+    NOTE_TIMING(523251), NOTE_TIMING(554365), NOTE_TIMING(587330), NOTE_TIMING(622254),
+    NOTE_TIMING(659255), NOTE_TIMING(698456), NOTE_TIMING(739989), NOTE_TIMING(783991),
+    NOTE_TIMING(830609), NOTE_TIMING(880000), NOTE_TIMING(932328), NOTE_TIMING(987767),
+    // Octave 6
+    NOTE_TIMING(1046502), NOTE_TIMING(1108731), NOTE_TIMING(1174659), NOTE_TIMING(1244508),
+    NOTE_TIMING(1318510), NOTE_TIMING(1396913), NOTE_TIMING(1479978), NOTE_TIMING(1567982),
+    NOTE_TIMING(1661219), NOTE_TIMING(1760000), NOTE_TIMING(1864655), NOTE_TIMING(1975533),
+    // Octave 7
+    NOTE_TIMING(2093005)
+};
+
+_Static_assert(sizeof(NOTE_TABLE) / sizeof(NOTE_TABLE[0]) == NOTE_MAX - NOTE_MIN + 1,
+               "note table must cover NOTE_MIN to NOTE_MAX");
+
+// Rests keep the timer running at this note's rate with the output disconnected
+#define REST_TIMING_NOTE  C6
+
+static volatile uint8_t tonePlaying = 0;
+static volatile uint8_t toneEndless = 0;
+static volatile uint32_t toneRemaining = 0;  // Output toggles left in the note
+
+// Note length in units for each length code
+static const uint8_t MELODY_UNITS[] PROGMEM = {1, 2, 3, 4, 5, 6, 8, 12};
+
+const uint8_t MELODY_STARTUP[] PROGMEM = {
+    50,
+    MELODY_REST(4),
+    MELODY_NOTE(C5, 3), MELODY_REST(1),
+    MELODY_NOTE(E5, 3), MELODY_REST(1),
+    MELODY_NOTE(G5, 3), MELODY_REST(1),
+    MELODY_NOTE(C6, 4),
+    MELODY_END
+};
+
+const uint8_t MELODY_FANFARE[] PROGMEM = {
+    100,
+    MELODY_NOTE(C5, 2), MELODY_NOTE(E5, 2),
+    MELODY_NOTE(G5, 2), MELODY_NOTE(C6, 4),
+    MELODY_END
+};
+
+const uint8_t MELODY_FALLING[] PROGMEM = {
+    100,
+    MELODY_NOTE(C6, 2), MELODY_NOTE(G5, 2),
+    MELODY_NOTE(E5, 2), MELODY_NOTE(C5, 4),
+    MELODY_END
+};
+
+const uint8_t MELODY_FAILURE[] PROGMEM = {
+    100,
+    MELODY_NOTE(C5, 3), MELODY_NOTE(G5, 5),
+    MELODY_END
+};
+
+// Next packed note in flash, 0 when idle. Advanced by the Timer2 interrupt,
+// so it is only written here with the compare interrupt masked
+static const uint8_t* volatile melodyNext = 0;
+static uint8_t melodyUnit = 0;               // Milliseconds per length unit
+
+static void melody_next(void);
+
+ISR(TIMER2_COMPA_vect) {
+    if (toneEndless) {
+        return;
+    }
+
+    if (--toneRemaining == 0) {
+        melody_next();
+    }
+}
+
 void buzzer_init(void) { 
     DDRD |= (1 << PD3);
     PORTD |= (1 << PD3);
 }
 
-void playTone(float frequency, uint32_t duration) {
-    uint8_t sreg = SREG;
-    cli();  // Disable interrupts for precise timing
-    
-    volatile uint32_t periodInMicro = (uint32_t)(1000000/frequency);
-    volatile uint32_t durationInMicro = duration * 1000;
-    
-    for (volatile uint32_t i = 0; i < durationInMicro/periodInMicro; i++) {
-        PORTD &= ~(1 << PD3);
-        
-        for (volatile uint16_t j = 0; j < periodInMicro/2/10; j++) {
-            _delay_us(10);
-        }
-        
-        PORTD |= (1 << PD3); 
-        
-        for (volatile uint16_t j = 0; j < periodInMicro/2/10; j++) {
-            _delay_us(10);
-        }
+/**
+ * Start Timer2 toggling OC2B every half period of a note
+ * @param note MIDI note number (NOTE_MIN to NOTE_MAX)
+ * @param duration_ms Duration in milliseconds, 0 plays until tone_stop()
+ * @param silent 1 to only run the timer for a rest, 0 to drive the buzzer
+ */
+static void tone_start_note(uint8_t note, uint16_t duration_ms, uint8_t silent) {
+    const NoteTiming* timing = &NOTE_TABLE[note - NOTE_MIN];
+    uint8_t compare = pgm_read_byte(&timing->compare);
+    uint8_t clock_select = pgm_read_byte(&timing->clock_select);
+    uint16_t toggles_per_ms = pgm_read_word(&timing->toggles_per_ms);
+
+    TCCR2B = 0;
+    TIMSK2 &= ~(1 << OCIE2A);
+
+    TCNT2 = 0;
+    OCR2A = compare;
+    OCR2B = 0;
+    toneEndless = (duration_ms == 0);
+    toneRemaining = ((uint32_t)duration_ms * toggles_per_ms + 128) >> 8;
+    if (toneRemaining == 0) {
+        toneRemaining = 1;
     }
-    
-    // Restore interrupt state
-    SREG = sreg;
+    tonePlaying = 1;
+
+    // CTC mode with OCR2A as top, toggle OC2B (PD3) on every compare match
+    TCCR2A = silent ? (1 << WGM21) : (1 << COM2B0) | (1 << WGM21);
+    if (silent) {
+        PORTD |= (1 << PD3);
+    }
+    TIFR2 = (1 << OCF2A);
+    // Only the compare interrupt, this also takes Timer2 back from the synthesizer
+    TIMSK2 = (1 << OCIE2A);
+    TCCR2B = clock_select;
+}
+
+/**
+ * Decode and start the next melody note from flash, or stop at the end
+ * Runs from the Timer2 interrupt when a note ends
+ */
+static void melody_next(void) {
+    uint8_t code = melodyNext ? pgm_read_byte(melodyNext) : MELODY_END;
+
+    if ((code & 0x1F) == MELODY_END) {
+        melodyNext = 0;
+        tone_stop();
+        return;
+    }
+
+    melodyNext++;
+
+    uint16_t duration_ms = pgm_read_byte(&MELODY_UNITS[code >> 5]) * (uint16_t)melodyUnit;
+    uint8_t note = code & 0x1F;
+
+    if (note == 0) {
+        tone_start_note(REST_TIMING_NOTE, duration_ms, 1);
+    } else {
+        tone_start_note(note + MELODY_NOTE_MIN - 1, duration_ms, 0);
+    }
+}
+
+void tone_start(uint8_t note, uint16_t duration_ms) {
+    TIMSK2 &= ~(1 << OCIE2A);
+    melodyNext = 0;
+
+    if (note < NOTE_MIN || note > NOTE_MAX) {
+        tone_stop();
+        return;
+    }
+
+    tone_start_note(note, duration_ms, 0);
+}
+
+void melody_play(const uint8_t* melody) {
+    TIMSK2 &= ~(1 << OCIE2A);
+
+    melodyUnit = pgm_read_byte(melody);
+    melodyNext = melody + 1;
+
+    melody_next();
+}
+
+uint8_t melody_is_playing(void) {
+    return tonePlaying;
+}
+
+void melody_stop(void) {
+    TIMSK2 &= ~(1 << OCIE2A);
+    melodyNext = 0;
+    tone_stop();
+}
+
+void tone_stop(void) {
+    TCCR2B = 0;
+    TCCR2A = 0;
+    TIMSK2 &= ~(1 << OCIE2A);
+
+    // Buzzer idles high
+    PORTD |= (1 << PD3);
+    tonePlaying = 0;
+}
+
+uint8_t tone_is_playing(void) {
+    return tonePlaying;
+}
+
+void play_tone(uint8_t note, uint16_t duration_ms) {
+    tone_start(note, duration_ms);
+    while (tone_is_playing());
 }
 
 void play_startup_sequence(void) {
     DDRD |= (1 << PD3);
     PORTD |= (1 << PD3);
     
-    _delay_ms(200);
-    
-    playTone(C5, 150);
-    _delay_ms(50);
-    playTone(E5, 150);
-    _delay_ms(50);
-    playTone(G5, 150);
-    _delay_ms(50);
-    playTone(C6, 200);
+    melody_play(MELODY_STARTUP);
 }
\ No newline at end of file
@@ -2,6 +2,9 @@
  * Sound Control Library for DJ Controller
  * 
  * Provides functions for controlling the piezo-electric speaker
+ * Tones are generated by Timer2 in hardware on OC2B (PD3), so interrupts
+ * stay enabled while a note plays. Starting a tone takes Timer2 back from
+ * the synthesizer library if it was running.
  */
 
 #ifndef SOUND_H
@@ -10,32 +13,101 @@
 #include <avr/io.h>
 #include <util/delay.h>
 #include <avr/interrupt.h>
+#include <avr/pgmspace.h>
 
 #define DURATION 250
 
-#define  C5      523.250
-#define  D5      587.330
-#define  E5      659.250
-#define  F5      698.460
-#define  G5      783.990
-#define  A5      880.000
-#define  B5      987.770
-#define  C6      1046.500
+// MIDI note numbers, the range covered by the note timing table
+#define  NOTE_MIN    36      // C2
+#define  NOTE_MAX    96      // C7
+
+#define  C4      60
+#define  C5      72
+#define  D5      74
+#define  E5      76
+#define  F5      77
+#define  G5      79
+#define  A5      81
+#define  B5      83
+#define  C6      84
+
+/*
+ * Packed melody format, stored in flash
+ * Byte 0 is the length of one time unit in milliseconds, followed by one
+ * byte per note and a MELODY_END terminator
+ *   bits 7-5: length code, 0-7 = 1, 2, 3, 4, 5, 6, 8 or 12 units
+ *   bits 4-0: note code, 0 = rest, 1-30 = MIDI note 60-89 (C4-F6),
+ *             31 = end of melody
+ */
+#define  MELODY_NOTE_MIN     60
+#define  MELODY_NOTE_MAX     89
+
+#define  MELODY_LENGTH(units) ((units) <= 6 ? (units) - 1 : (units) == 8 ? 6 : 7)
+#define  MELODY_NOTE(note, units) \
+    ((uint8_t)((MELODY_LENGTH(units) << 5) | ((note) - MELODY_NOTE_MIN + 1)))
+#define  MELODY_REST(units)  ((uint8_t)(MELODY_LENGTH(units) << 5))
+#define  MELODY_END          0x1F
+
+// Jingles shared by the apps, in flash
+extern const uint8_t MELODY_STARTUP[];
+extern const uint8_t MELODY_FANFARE[];
+extern const uint8_t MELODY_FALLING[];
+extern const uint8_t MELODY_FAILURE[];
 
 /**
  * Initialize the buzzer pin
+ * The tone driver needs its Timer2 interrupt, so the program must enable
+ * global interrupts once everything is set up
  */
 void buzzer_init(void);
 
 /**
- * Play a tone at the specified frequency for the specified duration
- * @param frequency Frequency in Hz
- * @param duration Duration in milliseconds
+ * Start a tone and return immediately
+ * @param note MIDI note number (NOTE_MIN to NOTE_MAX, e.g. C5), others stop the current tone
+ * @param duration_ms Duration in milliseconds, 0 plays until tone_stop()
+ */
+void tone_start(uint8_t note, uint16_t duration_ms);
+
+/**
+ * Stop the current tone
+ */
+void tone_stop(void);
+
+/**
+ * Check if a tone is still sounding
+ * @return 1 if a tone is playing, 0 otherwise
+ */
+uint8_t tone_is_playing(void);
+
+/**
+ * Play a tone and wait until it has finished
+ * @param note MIDI note number (e.g. C5)
+ * @param duration_ms Duration in milliseconds
+ */
+void play_tone(uint8_t note, uint16_t duration_ms);
+
+/**
+ * Play a packed melody from flash in the background
+ * Notes are decoded from program memory by the Timer2 interrupt one at a
+ * time, so a melody takes no SRAM
+ * Starting a tone or another melody cancels the running one
+ * @param melody PROGMEM melody in the packed format above
+ */
+void melody_play(const uint8_t* melody);
+
+/**
+ * Check if a melody (or single tone) is still playing
+ * @return 1 while playing, 0 once finished
+ */
+uint8_t melody_is_playing(void);
+
+/**
+ * Stop the running melody
  */
-void playTone(float frequency, uint32_t duration);
+void melody_stop(void);
 
 /**
- * Play a startup sound sequence
+ * Play a startup sound sequence in the background
  */
 void play_startup_sequence(void);
 
@@ -0,0 +1,289 @@
+/**
+ * Storage Implementation for DJ Controller
+ */
+
+#include "storage.h"
+
+#if defined(__AVR__)
+#include <avr/eeprom.h>
+#include <util/crc16.h>
+#else
+#include <string.h>
+
+uint8_t storage_host_eeprom[STORAGE_HOST_EEPROM_SIZE];
+uint32_t storage_host_byte_writes[STORAGE_HOST_EEPROM_SIZE];
+
+#define eeprom_is_ready() 1
+#define eeprom_busy_wait()
+
+static void eeprom_read_block(void* dst, const void* src, size_t size) {
+    memcpy(dst, storage_host_eeprom + (uintptr_t)src, size);
+}
+
+static void eeprom_update_byte(uint8_t* address, uint8_t value) {
+    if (storage_host_eeprom[(uintptr_t)address] != value) {
+        storage_host_eeprom[(uintptr_t)address] = value;
+        storage_host_byte_writes[(uintptr_t)address]++;
+    }
+}
+
+// Same as the avr-libc version, polynomial x^8 + x^2 + x + 1
+static uint8_t _crc8_ccitt_update(uint8_t crc, uint8_t data) {
+    crc ^= data;
+
+    for (uint8_t i = 0; i < 8; i++) {
+        crc = (crc & 0x80) ? (crc << 1) ^ 0x07 : crc << 1;
+    }
+
+    return crc;
+}
+#endif
+
+#define NO_SLOT 0xFF
+#define NO_KEY 0xFF
+#define KEY_OFFSET 2
+#define WRITE_STEPS 9
+#define WRITE_IDLE WRITE_STEPS
+
+// Records older than this are written again, so sequence numbers always compare correctly
+#define REFRESH_AGE 0x4000
+
+_Static_assert(STORAGE_SLOTS < NO_SLOT, "slot numbers must fit in a byte");
+
+typedef struct {
+    uint16_t seq;
+    uint8_t key;
+    uint8_t value[4];
+    uint8_t crc;
+} StorageRecord;
+
+_Static_assert(sizeof(StorageRecord) == STORAGE_RECORD_SIZE, "record must be 8 bytes");
+
+// Byte order of a record write. The key is cleared first and written last,
+// so a record cut off at any point has no valid key. The CRC alone would
+// pass one torn record in 256
+static const uint8_t WRITE_ORDER[WRITE_STEPS] = { KEY_OFFSET, 0, 1, 3, 4, 5, 6, 7, KEY_OFFSET };
+
+static uint32_t values[STORAGE_MAX_KEYS];
+static uint16_t keySeq[STORAGE_MAX_KEYS];     // Sequence number of each key's live record
+static uint8_t keySlot[STORAGE_MAX_KEYS];     // Slot of each key's live record, NO_SLOT if none
+static uint8_t validKeys = 0;                 // Keys that have a value
+static uint8_t dirtyKeys = 0;                 // Keys whose value still has to be written
+
+static uint8_t head = 0;                      // Next slot to write
+static uint16_t nextSeq = 0;
+
+static StorageRecord pending;                 // Record being written
+static uint8_t pendingSlot;
+static uint8_t pendingByte = WRITE_IDLE;      // Next step of WRITE_ORDER
+static uint16_t writeCount = 0;
+
+/**
+ * Get the EEPROM address of a slot
+ * @param slot Slot number
+ * @return Address of the slot's first byte
+ */
+static uint8_t* storage_slot_address(uint8_t slot) {
+    return (uint8_t*)(uintptr_t)(STORAGE_START_ADDRESS + (uint16_t)slot * STORAGE_RECORD_SIZE);
+}
+
+/**
+ * Compute the CRC of a record, all bytes but the CRC itself
+ * Starts from 0xFF so an all-zero slot does not pass
+ * @param record Pointer to the record
+ * @return CRC-8
+ */
+static uint8_t storage_crc(const StorageRecord* record) {
+    const uint8_t* bytes = (const uint8_t*)record;
+    uint8_t crc = 0xFF;
+
+    for (uint8_t i = 0; i < STORAGE_RECORD_SIZE - 1; i++) {
+        crc = _crc8_ccitt_update(crc, bytes[i]);
+    }
+
+    return crc;
+}
+
+/**
+ * Check if sequence number a is newer than b
+ * @param a Sequence number
+ * @param b Sequence number
+ * @return 1 if a is newer
+ */
+static uint8_t storage_newer(uint16_t a, uint16_t b) {
+    return (int16_t)(a - b) > 0;
+}
+
+/**
+ * Check if a slot holds the live record of any key
+ * @param slot Slot number
+ * @return Key of the record, or STORAGE_MAX_KEYS if the slot is free
+ */
+static uint8_t storage_slot_owner(uint8_t slot) {
+    for (uint8_t key = 0; key < STORAGE_MAX_KEYS; key++) {
+        if (keySlot[key] == slot) {
+            return key;
+        }
+    }
+
+    return STORAGE_MAX_KEYS;
+}
+
+void storage_init(void) {
+    uint8_t newestSlot = NO_SLOT;
+    uint16_t newestSeq = 0;
+
+    validKeys = 0;
+    dirtyKeys = 0;
+    pendingByte = WRITE_IDLE;
+
+    for (uint8_t key = 0; key < STORAGE_MAX_KEYS; key++) {
+        keySlot[key] = NO_SLOT;
+    }
+
+    for (uint8_t slot = 0; slot < STORAGE_SLOTS; slot++) {
+        StorageRecord record;
+        eeprom_read_block(&record, storage_slot_address(slot), STORAGE_RECORD_SIZE);
+
+        // Erased EEPROM reads 0xFF, which is never a valid key
+        if (record.key >= STORAGE_MAX_KEYS || record.crc != storage_crc(&record)) {
+            continue;
+        }
+
+        if (newestSlot == NO_SLOT || storage_newer(record.seq, newestSeq)) {
+            newestSlot = slot;
+            newestSeq = record.seq;
+        }
+
+        uint8_t mask = 1 << record.key;
+
+        if (!(validKeys & mask) || storage_newer(record.seq, keySeq[record.key])) {
+            validKeys |= mask;
+            keySeq[record.key] = record.seq;
+            keySlot[record.key] = slot;
+            values[record.key] = (uint32_t)record.value[0] |
+                                 ((uint32_t)record.value[1] << 8) |
+                                 ((uint32_t)record.value[2] << 16) |
+                                 ((uint32_t)record.value[3] << 24);
+        }
+    }
+
+    if (newestSlot == NO_SLOT) {
+        head = 0;
+        nextSeq = 0;
+    } else {
+        head = (newestSlot + 1) % STORAGE_SLOTS;
+        nextSeq = newestSeq + 1;
+    }
+}
+
+uint8_t storage_get(uint8_t key, uint32_t* value) {
+    if (key >= STORAGE_MAX_KEYS || !(validKeys & (1 << key))) {
+        return 0;
+    }
+
+    *value = values[key];
+
+    return 1;
+}
+
+uint8_t storage_set(uint8_t key, uint32_t value) {
+    if (key >= STORAGE_MAX_KEYS) {
+        return 0;
+    }
+
+    uint8_t mask = 1 << key;
+
+    if ((validKeys & mask) && values[key] == value) {
+        return 1;
+    }
+
+    values[key] = value;
+    validKeys |= mask;
+    dirtyKeys |= mask;
+
+    return 1;
+}
+
+/**
+ * Start writing the record of the lowest dirty key
+ * The head steps over slots that hold live records
+ */
+static void storage_start_record(void) {
+    uint8_t owner;
+
+    while ((owner = storage_slot_owner(head)) != STORAGE_MAX_KEYS) {
+        if ((uint16_t)(nextSeq - keySeq[owner]) > REFRESH_AGE) {
+            dirtyKeys |= 1 << owner;
+        }
+        head = (head + 1) % STORAGE_SLOTS;
+    }
+
+    uint8_t key = 0;
+    while (!(dirtyKeys & (1 << key))) {
+        key++;
+    }
+    dirtyKeys &= ~(1 << key);
+
+    uint32_t value = values[key];
+
+    pending.seq = nextSeq;
+    pending.key = key;
+    pending.value[0] = value;
+    pending.value[1] = value >> 8;
+    pending.value[2] = value >> 16;
+    pending.value[3] = value >> 24;
+    pending.crc = storage_crc(&pending);
+
+    pendingSlot = head;
+    pendingByte = 0;
+}
+
+/**
+ * Finish a record once all its bytes are written
+ * It becomes the key's live record, the old one is free from now on
+ */
+static void storage_finish_record(void) {
+    keySlot[pending.key] = pendingSlot;
+    keySeq[pending.key] = pending.seq;
+
+    head = (pendingSlot + 1) % STORAGE_SLOTS;
+    nextSeq++;
+    writeCount++;
+    pendingByte = WRITE_IDLE;
+}
+
+void storage_poll(void) {
+    if (!eeprom_is_ready()) {
+        return;
+    }
+
+    if (pendingByte == WRITE_IDLE) {
+        if (dirtyKeys == 0) {
+            return;
+        }
+        storage_start_record();
+    }
+
+    uint8_t offset = WRITE_ORDER[pendingByte];
+    uint8_t data = pendingByte == 0 ? NO_KEY : ((const uint8_t*)&pending)[offset];
+
+    // Unchanged bytes are not written again
+    eeprom_update_byte(storage_slot_address(pendingSlot) + offset, data);
+
+    if (++pendingByte == WRITE_STEPS) {
+        storage_finish_record();
+    }
+}
+
+void storage_flush(void) {
+    while (dirtyKeys != 0 || pendingByte != WRITE_IDLE) {
+        storage_poll();
+    }
+
+    eeprom_busy_wait();
+}
+
+uint16_t storage_writes(void) {
+    return writeCount;
+}
@@ -0,0 +1,100 @@
+/**
+ * Storage Library for DJ Controller
+ * 
+ * Provides a small key-value store in EEPROM for state that has to
+ * survive a power cycle, such as the playlist position and high scores.
+ *
+ * Values are kept in RAM and written to an append-only log of 8-byte
+ * records (sequence number, key, 32-bit value, CRC-8). The log wraps
+ * around STORAGE_SLOTS slots, so writes are spread over the whole area
+ * (wear leveling). Only records that have been superseded are ever
+ * overwritten. A record's key is cleared before the rest is written and
+ * set again last, so a record cut off by a reset is skipped and the older
+ * one is used; the CRC catches corrupted bytes.
+ *
+ * Endurance: the ATmega328P EEPROM is rated for 100,000 erase/write
+ * cycles per cell. Live records are stepped over, so every slot is
+ * written at most once per STORAGE_SLOTS - STORAGE_MAX_KEYS records. The
+ * key byte is written twice per record, which limits the log to about
+ * 6 million records with the defaults (STORAGE_ENDURANCE_RECORDS). At one
+ * write a minute that is over 11 years.
+ */
+
+#ifndef STORAGE_H
+#define STORAGE_H
+
+#include <stdint.h>
+
+// EEPROM area used by the log, override with -D... in build_flags
+#ifndef STORAGE_START_ADDRESS
+#define STORAGE_START_ADDRESS 0
+#endif
+#ifndef STORAGE_SLOTS
+#define STORAGE_SLOTS 128       // 8 bytes each, the whole 1 KB EEPROM
+#endif
+
+#define STORAGE_RECORD_SIZE 8
+#define STORAGE_MAX_KEYS 8
+
+// Rated cycles per cell, halved for the key byte, times the records that fit
+// between two writes of a slot
+#define STORAGE_ENDURANCE_RECORDS (100000UL / 2 * (STORAGE_SLOTS - STORAGE_MAX_KEYS))
+
+// Keys, shared by all programs so a reflashed board does not misread old values
+#define STORAGE_KEY_PLAYLIST 0       // Current track, total tracks, play state
+#define STORAGE_KEY_LED_BRIGHTNESS 1 // LED brightness ceiling (0-LED_LEVEL_MAX)
+// Key 2 held a serial baud rate that was never set, do not reuse it
+#define STORAGE_KEY_NIM_SCORE 3      // Player wins, computer wins
+#define STORAGE_KEY_SIMON_SCORE 4    // Highest level completed
+
+/**
+ * Read the log and restore the latest value of every key
+ * Reads all STORAGE_SLOTS records once, about 2 ms with the defaults
+ */
+void storage_init(void);
+
+/**
+ * Get the stored value of a key
+ * @param key Key (below STORAGE_MAX_KEYS)
+ * @param value Filled in with the value if the key has one
+ * @return 1 if the key has a value, 0 otherwise
+ */
+uint8_t storage_get(uint8_t key, uint32_t* value);
+
+/**
+ * Set the value of a key
+ * The value is written to EEPROM in the background by storage_poll(),
+ * setting the same value again does not write anything
+ * @param key Key (below STORAGE_MAX_KEYS)
+ * @param value New value
+ * @return 1 if successful, 0 if the key is invalid
+ */
+uint8_t storage_set(uint8_t key, uint32_t value);
+
+/**
+ * Write the next byte of pending values when the EEPROM is ready
+ * Call often from the main loop, a record takes 9 calls of 3.4 ms each
+ */
+void storage_poll(void);
+
+/**
+ * Write all pending values, waiting for the EEPROM
+ */
+void storage_flush(void);
+
+/**
+ * Get the number of records written since reset
+ * @return Record count
+ */
+uint16_t storage_writes(void);
+
+#if !defined(__AVR__)
+// PC build for the host tests: the EEPROM is emulated in RAM, and every
+// byte that actually changes is counted
+#define STORAGE_HOST_EEPROM_SIZE (STORAGE_START_ADDRESS + STORAGE_SLOTS * STORAGE_RECORD_SIZE)
+
+extern uint8_t storage_host_eeprom[STORAGE_HOST_EEPROM_SIZE];
+extern uint32_t storage_host_byte_writes[STORAGE_HOST_EEPROM_SIZE];
+#endif
+
+#endif
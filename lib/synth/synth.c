@@ -0,0 +1,196 @@
+/**
+ * Synthesizer Implementation for DJ Controller
+ */
+
+#include "synth.h"
+#include "sound.h"
+#include <avr/interrupt.h>
+#include <avr/pgmspace.h>
+#include <util/atomic.h>
+
+// Phase increment per Hz is 65536 / 31372.5 = 2.089, approximated as 2139 / 1024
+#define PHASE_STEP_NUM      2139UL
+#define PHASE_STEP_SHIFT    10
+
+// Voice durations count down in blocks of 32 samples (1.020 ms)
+#define BLOCK_SHIFT         5
+
+static const int8_t SINE_TABLE[256] PROGMEM = {
+       0,    3,    6,    9,   12,   16,   19,   22,   25,   28,   31,   34,   37,   40,   43,   46,
+      49,   51,   54,   57,   60,   63,   65,   68,   71,   73,   76,   78,   81,   83,   85,   88,
+      90,   92,   94,   96,   98,  100,  102,  104,  106,  107,  109,  111,  112,  113,  115,  116,
+     117,  118,  120,  121,  122,  122,  123,  124,  125,  125,  126,  126,  126,  127,  127,  127,
+     127,  127,  127,  127,  126,  126,  126,  125,  125,  124,  123,  122,  122,  121,  120,  118,
+     117,  116,  115,  113,  112,  111,  109,  107,  106,  104,  102,  100,   98,   96,   94,   92,
+      90,   88,   85,   83,   81,   78,   76,   73,   71,   68,   65,   63,   60,   57,   54,   51,
+      49,   46,   43,   40,   37,   34,   31,   28,   25,   22,   19,   16,   12,    9,    6,    3,
+       0,   -3,   -6,   -9,  -12,  -16,  -19,  -22,  -25,  -28,  -31,  -34,  -37,  -40,  -43,  -46,
+     -49,  -51,  -54,  -57,  -60,  -63,  -65,  -68,  -71,  -73,  -76,  -78,  -81,  -83,  -85,  -88,
+     -90,  -92,  -94,  -96,  -98, -100, -102, -104, -106, -107, -109, -111, -112, -113, -115, -116,
+    -117, -118, -120, -121, -122, -122, -123, -124, -125, -125, -126, -126, -126, -127, -127, -127,
+    -127, -127, -127, -127, -126, -126, -126, -125, -125, -124, -123, -122, -122, -121, -120, -118,
+    -117, -116, -115, -113, -112, -111, -109, -107, -106, -104, -102, -100,  -98,  -96,  -94,  -92,
+     -90,  -88,  -85,  -83,  -81,  -78,  -76,  -73,  -71,  -68,  -65,  -63,  -60,  -57,  -54,  -51,
+     -49,  -46,  -43,  -40,  -37,  -34,  -31,  -28,  -25,  -22,  -19,  -16,  -12,   -9,   -6,   -3
+};
+
+static const int8_t TRIANGLE_TABLE[256] PROGMEM = {
+       0,    2,    4,    6,    8,   10,   12,   14,   16,   18,   20,   22,   24,   26,   28,   30,
+      32,   34,   36,   38,   40,   42,   44,   46,   48,   50,   52,   54,   56,   58,   60,   62,
+      64,   65,   67,   69,   71,   73,   75,   77,   79,   81,   83,   85,   87,   89,   91,   93,
+      95,   97,   99,  101,  103,  105,  107,  109,  111,  113,  115,  117,  119,  121,  123,  125,
+     127,  125,  123,  121,  119,  117,  115,  113,  111,  109,  107,  105,  103,  101,   99,   97,
+      95,   93,   91,   89,   87,   85,   83,   81,   79,   77,   75,   73,   71,   69,   67,   65,
+      64,   62,   60,   58,   56,   54,   52,   50,   48,   46,   44,   42,   40,   38,   36,   34,
+      32,   30,   28,   26,   24,   22,   20,   18,   16,   14,   12,   10,    8,    6,    4,    2,
+       0,   -2,   -4,   -6,   -8,  -10,  -12,  -14,  -16,  -18,  -20,  -22,  -24,  -26,  -28,  -30,
+     -32,  -34,  -36,  -38,  -40,  -42,  -44,  -46,  -48,  -50,  -52,  -54,  -56,  -58,  -60,  -62,
+     -64,  -65,  -67,  -69,  -71,  -73,  -75,  -77,  -79,  -81,  -83,  -85,  -87,  -89,  -91,  -93,
+     -95,  -97,  -99, -101, -103, -105, -107, -109, -111, -113, -115, -117, -119, -121, -123, -125,
+    -127, -125, -123, -121, -119, -117, -115, -113, -111, -109, -107, -105, -103, -101,  -99,  -97,
+     -95,  -93,  -91,  -89,  -87,  -85,  -83,  -81,  -79,  -77,  -75,  -73,  -71,  -69,  -67,  -65,
+     -64,  -62,  -60,  -58,  -56,  -54,  -52,  -50,  -48,  -46,  -44,  -42,  -40,  -38,  -36,  -34,
+     -32,  -30,  -28,  -26,  -24,  -22,  -20,  -18,  -16,  -14,  -12,  -10,   -8,   -6,   -4,   -2
+};
+
+typedef struct {
+    const int8_t* wave;     // Wavetable in flash
+    uint16_t phase;         // Phase accumulator, top 8 bits index the table
+    uint16_t increment;     // Phase step per sample
+    uint16_t remaining;     // Blocks left, 0 = until switched off
+    uint8_t active;
+} Voice;
+
+static volatile Voice voices[SYNTH_VOICES];
+static volatile uint8_t nextSample = 128;
+static volatile uint16_t isrCyclesMax = 0;
+static uint8_t blockCount = 0;
+
+ISR(TIMER2_OVF_vect) {
+    // The compare match at TOP marks the second half of the period, forget
+    // the one from the previous period
+    TIFR2 = (1 << OCF2A);
+
+    // Output the sample computed last time first. OCR2B is latched at TOP,
+    // so the sample lands without jitter
+    OCR2B = nextSample;
+
+    int16_t mix = 0;
+    uint8_t blockEnd = (++blockCount & ((1 << BLOCK_SHIFT) - 1)) == 0;
+
+    for (uint8_t i = 0; i < SYNTH_VOICES; i++) {
+        volatile Voice* voice = &voices[i];
+
+        if (!voice->active) {
+            continue;
+        }
+
+        mix += (int8_t)pgm_read_byte(&voice->wave[voice->phase >> 8]);
+        voice->phase += voice->increment;
+
+        if (blockEnd && voice->remaining && --voice->remaining == 0) {
+            voice->active = 0;
+        }
+    }
+
+    nextSample = (uint8_t)((mix >> 1) + 128);
+
+    // Cycles since the overflow at BOTTOM that triggered us. TCNT2 counts up
+    // to 255 and back down, the TOP match tells the halves apart. Read the
+    // flags before TCNT2, so a TOP passed in between costs a cycle or two
+    // instead of half a period. A pending overflow means the handler ran
+    // past the next sample and the real count is unknown
+    uint8_t flags = TIFR2;
+    uint16_t cycles = TCNT2;
+    if (flags & (1 << TOV2)) {
+        cycles = SYNTH_ISR_OVERRUN;
+    } else if (flags & (1 << OCF2A)) {
+        cycles = SYNTH_CYCLE_BUDGET - cycles;
+    }
+    if (cycles > isrCyclesMax) {
+        isrCyclesMax = cycles;
+    }
+}
+
+void synth_start(void) {
+    melody_stop();
+
+    for (uint8_t i = 0; i < SYNTH_VOICES; i++) {
+        voices[i].active = 0;
+    }
+    nextSample = 128;
+    isrCyclesMax = 0;
+
+    DDRD |= (1 << PD3);
+
+    // Phase-correct PWM with TOP 0xFF, non-inverting on OC2B, no prescaler:
+    // 510 cycles per period, one overflow and one sample each. OCR2A only
+    // flags TOP for the cycle measurement
+    OCR2B = 128;
+    OCR2A = 0xFF;
+    TCCR2A = (1 << COM2B1) | (1 << WGM20);
+    TIFR2 = (1 << TOV2) | (1 << OCF2A);
+    TIMSK2 = (1 << TOIE2);
+    TCCR2B = (1 << CS20);
+}
+
+void synth_stop(void) {
+    TCCR2B = 0;
+    TCCR2A = 0;
+    TIMSK2 &= ~(1 << TOIE2);
+
+    // Buzzer idles high
+    PORTD |= (1 << PD3);
+}
+
+uint8_t synth_is_running(void) {
+    return (TIMSK2 & (1 << TOIE2)) ? 1 : 0;
+}
+
+uint8_t synth_note(uint8_t voice, uint16_t frequency, uint8_t wave, uint16_t duration_ms) {
+    if (voice >= SYNTH_VOICES || frequency == 0 || frequency > 15000) {
+        return 0;
+    }
+
+    uint16_t increment = (uint16_t)(((uint32_t)frequency * PHASE_STEP_NUM) >> PHASE_STEP_SHIFT);
+    // 1 ms is 31.37 samples, so 251 / 256 blocks of 32 samples; round up
+    uint16_t blocks = (uint16_t)(((uint32_t)duration_ms * 251 + 255) >> 8);
+
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        voices[voice].wave = (wave == SYNTH_TRIANGLE) ? TRIANGLE_TABLE : SINE_TABLE;
+        voices[voice].phase = 0;
+        voices[voice].increment = increment;
+        voices[voice].remaining = blocks;
+        voices[voice].active = 1;
+    }
+
+    return 1;
+}
+
+void synth_voice_off(uint8_t voice) {
+    if (voice < SYNTH_VOICES) {
+        voices[voice].active = 0;
+    }
+}
+
+uint8_t synth_voice_active(uint8_t voice) {
+    if (voice >= SYNTH_VOICES) {
+        return 0;
+    }
+
+    return voices[voice].active;
+}
+
+void synth_click(void) {
+    synth_note(SYNTH_VOICES - 1, SYNTH_CLICK_FREQ, SYNTH_TRIANGLE, SYNTH_CLICK_MS);
+}
+
+uint16_t synth_isr_cycles_max(void) {
+    uint16_t cycles;
+
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        cycles = isrCyclesMax;
+    }
+
+    return cycles;
+}
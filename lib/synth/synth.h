@@ -0,0 +1,96 @@
+/**
+ * Synthesizer Library for DJ Controller
+ * 
+ * Provides a two-voice direct digital synthesis engine on the buzzer
+ * Timer2 runs as a 31.4 kHz phase-correct PWM on OC2B (PD3) acting as a
+ * DAC, and its overflow interrupt mixes the voices from wavetables in
+ * flash, one sample per PWM period. The synthesizer and the square-wave tone driver in the sound
+ * library share Timer2, so only one of them runs at a time.
+ *
+ * Not used by any of the programs yet. The interrupt cost has not been
+ * measured on the board; check synth_isr_cycles_max() before using the
+ * synthesizer next to other interrupt-driven code.
+ */
+
+#ifndef SYNTH_H
+#define SYNTH_H
+
+#include <avr/io.h>
+
+#define SYNTH_VOICES        2
+#define SYNTH_SAMPLE_RATE   31373  // F_CPU / 510, rounded
+
+// Waveforms
+#define SYNTH_SINE          0
+#define SYNTH_TRIANGLE      1
+
+// Beat click: short high triangle blip on the last voice
+#define SYNTH_CLICK_FREQ    2000
+#define SYNTH_CLICK_MS      8
+
+// Cycles between two samples, one phase-correct PWM period; the interrupt
+// must stay well below this
+#define SYNTH_CYCLE_BUDGET  510
+
+// Reported when the interrupt ran past the next sample
+#define SYNTH_ISR_OVERRUN   0xFFFF
+
+/**
+ * Take over Timer2 and start the synthesizer with all voices silent
+ * Stops any tone or melody playing on the sound library driver
+ * Samples are mixed in the Timer2 interrupt, global interrupts must be on
+ */
+void synth_start(void);
+
+/**
+ * Stop the synthesizer and release Timer2
+ * The buzzer pin returns to its idle high level
+ */
+void synth_stop(void);
+
+/**
+ * Check if the synthesizer owns Timer2
+ * @return 1 if running, 0 otherwise
+ */
+uint8_t synth_is_running(void);
+
+/**
+ * Start a note on one voice, replacing whatever it was playing
+ * @param voice Voice index (0 to SYNTH_VOICES - 1)
+ * @param frequency Frequency in Hz (1-15000)
+ * @param wave Waveform (SYNTH_SINE or SYNTH_TRIANGLE)
+ * @param duration_ms Duration in milliseconds, 0 plays until synth_voice_off()
+ * @return 1 if started, 0 for an invalid voice or frequency
+ */
+uint8_t synth_note(uint8_t voice, uint16_t frequency, uint8_t wave, uint16_t duration_ms);
+
+/**
+ * Silence one voice
+ * @param voice Voice index
+ */
+void synth_voice_off(uint8_t voice);
+
+/**
+ * Check if a voice is sounding
+ * @param voice Voice index
+ * @return 1 if active, 0 otherwise
+ */
+uint8_t synth_voice_active(uint8_t voice);
+
+/**
+ * Play a short beat click on the last voice without blocking
+ */
+void synth_click(void);
+
+/**
+ * Get the longest sample interrupt seen since synth_start()
+ * Measured from the Timer2 overflow to the end of the handler, so it
+ * includes interrupt latency. Covers the whole sample period, as long as
+ * the handler starts within its first half; compare against
+ * SYNTH_CYCLE_BUDGET
+ * @return CPU cycles, or SYNTH_ISR_OVERRUN once the handler ran past the
+ *         next sample
+ */
+uint16_t synth_isr_cycles_max(void);
+
+#endif
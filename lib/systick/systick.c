@@ -0,0 +1,37 @@
+/**
+ * System Tick Implementation
+ */
+
+#include "systick.h"
+#include <avr/interrupt.h>
+#include <util/atomic.h>
+
+static volatile uint32_t tickMillis = 0;
+
+void systick_hook(void) __attribute__((weak));
+
+void systick_hook(void) {
+}
+
+ISR(TIMER1_COMPA_vect) {
+    tickMillis++;
+    systick_hook();
+}
+
+void systick_init(void) {
+    // CTC mode, prescaler 64: 16MHz / 64 / 250 = 1 kHz
+    TCCR1A = 0;
+    TCCR1B = (1 << WGM12) | (1 << CS11) | (1 << CS10);
+    OCR1A = 249;
+    TIMSK1 |= (1 << OCIE1A);
+}
+
+uint32_t systick_millis(void) {
+    uint32_t now;
+
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        now = tickMillis;
+    }
+
+    return now;
+}
@@ -0,0 +1,31 @@
+/**
+ * System Tick Library
+ * 
+ * Provides a 1 ms time base on Timer1 for timeouts and rate limiting
+ */
+
+#ifndef SYSTICK_H
+#define SYSTICK_H
+
+#include <avr/io.h>
+
+/**
+ * Start Timer1 in CTC mode with a 1 ms compare interrupt
+ * Interrupts must be enabled with sei() for the tick to run
+ */
+void systick_init(void);
+
+/**
+ * Get the number of milliseconds since systick_init()
+ * @return Milliseconds (wraps after ~49 days)
+ */
+uint32_t systick_millis(void);
+
+/**
+ * Called from the tick interrupt every millisecond
+ * Weak default does nothing; an application can define its own
+ * to run short periodic work. Keep it short, it runs with interrupts off.
+ */
+void systick_hook(void);
+
+#endif
@@ -3,14 +3,35 @@
  */
 
 #include "usart.h"
+#include <avr/interrupt.h>
+
+#define RX_MASK (USART_RX_BUFFER_SIZE - 1)
+
+_Static_assert((USART_RX_BUFFER_SIZE & RX_MASK) == 0, "USART_RX_BUFFER_SIZE must be a power of two");
+
+// Received bytes, filled by the interrupt and emptied by receive_byte()
+static volatile uint8_t rxBuffer[USART_RX_BUFFER_SIZE];
+static volatile uint8_t rxHead = 0;
+static volatile uint8_t rxTail = 0;
+
+ISR(USART_RX_vect) {
+    uint8_t data = UDR0;
+    uint8_t next = (rxHead + 1) & RX_MASK;
+
+    // A full buffer drops the byte
+    if (next != rxTail) {
+        rxBuffer[rxHead] = data;
+        rxHead = next;
+    }
+}
 
 void usart_init(void) {
     // Set baud rate to 9600 bps for 16MHz clock
     UBRR0H = 0;
     UBRR0L = 103;  // 16MHz / (16 * 9600) - 1 = 103
     
-    // Enable transmitter and receiver
-    UCSR0B = (1 << TXEN0) | (1 << RXEN0);
+    // Enable transmitter, receiver and receive interrupt
+    UCSR0B = (1 << TXEN0) | (1 << RXEN0) | (1 << RXCIE0);
     
     // Set frame format: 8 data bits, 1 stop bit, no parity
     UCSR0C = (1 << UCSZ01) | (1 << UCSZ00);
@@ -26,14 +47,17 @@ void transmit_byte(uint8_t data) {
 
 uint8_t receive_byte(void) {
     // Wait for data to be received
-    while (!(UCSR0A & (1 << RXC0)));
+    while (rxHead == rxTail);
     
     // Get and return received data from buffer
-    return UDR0;
+    uint8_t data = rxBuffer[rxTail];
+    rxTail = (rxTail + 1) & RX_MASK;
+
+    return data;
 }
 
 uint8_t is_data_available(void) {
-    return (UCSR0A & (1 << RXC0));
+    return rxHead != rxTail;
 }
 
 void transmit_string(const char* str) {
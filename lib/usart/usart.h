@@ -14,6 +14,10 @@
  */
 void usart_init(void);
 
+// Bytes buffered by the receive interrupt, a power of two. Holds a few
+// frames while the main loop is busy with the display
+#define USART_RX_BUFFER_SIZE 32
+
 /**
  * Send a byte over UART
  * @param data The byte to send
@@ -22,6 +26,7 @@ void transmit_byte(uint8_t data);
 
 /**
  * Receive a byte from UART (blocking)
+ * Bytes are buffered by the receive interrupt, so interrupts must be enabled
  * @return The received byte
  */
 uint8_t receive_byte(void);
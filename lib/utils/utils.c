@@ -100,7 +100,7 @@ void trackChangeEffect(uint8_t trackNumber) {
  */
 void startupAnimation(void) {
     // Initialize random seed for better randomness
-    srand(readADC(BPM_POT));
+    srand(read_adc(BPM_POT_PIN));
     
     // Display welcome message - now non-blocking for scrolling
     scrollText("DJ CONTROLLER READY", 2);
@@ -2,52 +2,23 @@
 #include <util/delay.h>
 #include <stdlib.h>
 #include <stdio.h>
-#include <time.h>
 #include "leds.h"
 #include "display.h"
 #include "buttons.h"
 #include "usart.h"
 #include "sound.h"
+#include "random.h"
+#include "systick.h"
+#include "morse.h"
 
-#define DOT_DURATION 100    
-#define DASH_DURATION 400    
-#define SYMBOL_SPACE 100  
-#define LETTER_SPACE 600     
+#define MORSE_WPM 10         // Overall speed
+#define MORSE_CHAR_WPM 18    // Farnsworth character speed
+#define MORSE_NOTE C6
 #define THINKING_TIME 2000  
 
-const char* morse_codes[] = {
-    ".-",    // A
-    "-...",  // B
-    "-.-.",  // C
-    "-..",   // D
-    ".",     // E
-    "..-.",  // F
-    "--.",   // G
-    "....",  // H
-    "..",    // I
-    ".---",  // J
-    "-.-",   // K
-    ".-..",  // L
-    "--",    // M
-    "-.",    // N
-    "---",   // O
-    ".--.",  // P
-    "--.-",  // Q
-    ".-.",   // R
-    "...",   // S
-    "-",     // T
-    "..-",   // U
-    "...-",  // V
-    ".--",   // W
-    "-..-",  // X
-    "-.--",  // Y
-    "--.."   // Z
-};
-
-const char characters[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZ";
-
 void countdown_pattern(void);
-void show_morse_code(const char* morse);
+void morse_key(uint8_t down);
+void wait_for_morse(void);
 void show_morse_for_character(char character);
 void led_dance(void);
 void show_morse_for_string(const char* str);
@@ -58,8 +29,15 @@ int main(void) {
     buttons_init();
     usart_init();
     buzzer_init();
+    systick_init();
+
+    // Tones, LED effects and the systick run from timer interrupts
+    sei();
     
-    srand(TCNT0);
+    morse_init(morse_key);
+    morse_set_speed(MORSE_WPM, MORSE_CHAR_WPM);
+    
+    random_global_init();
 
     _delay_ms(500);
     display_string("MRSE");
@@ -79,8 +57,7 @@ int main(void) {
             _delay_ms(1);
         }
         
-        uint8_t random_index = rand() % 26;
-        char selected_char = characters[random_index];
+        char selected_char = 'A' + random_global_int_range(0, 25);
         
         show_morse_for_character(selected_char);
       
@@ -174,38 +151,37 @@ void countdown_pattern(void) {
     }
 }
 
+void systick_hook(void) {
+    morse_tick();
+}
+
 /**
- * Display a Morse code sequence on all LEDs
- * @param morse The Morse code string (dots and dashes)
+ * Key the buzzer and all LEDs for the Morse keyer
+ * Runs from the system tick interrupt
+ * @param down 1 to start a dot or dash, 0 to end it
  */
-void show_morse_code(const char* morse) {
-    for (uint8_t i = 0; morse[i] != '\0'; i++) {
+void morse_key(uint8_t down) {
+    if (down) {
+        tone_start(MORSE_NOTE, 0);
         led_on(LED_PLAY_PIN);
         led_on(LED_TRACK_PIN);
         led_on(LED_SEEK_PIN);
         led_on(LED_STATUS_PIN);
-        
-        if (morse[i] == '.') {
-            playTone(C6, DOT_DURATION);
-
-        } else if (morse[i] == '-') {
-            playTone(C5, DASH_DURATION);
-        }
-        
+    } else {
+        tone_stop();
         led_off(LED_PLAY_PIN);
         led_off(LED_TRACK_PIN);
         led_off(LED_SEEK_PIN);
         led_off(LED_STATUS_PIN);
-        
-        for (uint16_t j = 0; j < SYMBOL_SPACE; j++) {
-            display_update(1);
-            _delay_ms(1);
-        }
     }
+}
 
-    for (uint16_t j = 0; j < (LETTER_SPACE - SYMBOL_SPACE); j++) {
+/**
+ * Keep the display running until the keyer has sent everything
+ */
+void wait_for_morse(void) {
+    while (morse_busy()) {
         display_update(1);
-        _delay_ms(1);
     }
 }
 
@@ -214,13 +190,10 @@ void show_morse_code(const char* morse) {
  * @param character The character to show in Morse code (A-Z)
  */
 void show_morse_for_character(char character) {
-    if (character >= 'A' && character <= 'Z') {
-        uint8_t index = character - 'A';
-        show_morse_code(morse_codes[index]);
-    } else if (character >= 'a' && character <= 'z') {
-        uint8_t index = character - 'a';
-        show_morse_code(morse_codes[index]);
-    }
+    char text[2] = { character, '\0' };
+
+    morse_send(text);
+    wait_for_morse();
 }
 
 /**
@@ -235,6 +208,8 @@ void led_dance(void) {
         LED_STATUS_PIN
     };
     
+    const uint8_t notes[] = { C5, E5, G5, B5 };
+    
     uint8_t num_leds = 4;
     
     display_string("DANC");
@@ -242,9 +217,9 @@ void led_dance(void) {
     for (uint8_t cycle = 0; cycle < 3; cycle++) {
         for (uint8_t i = 0; i < num_leds; i++) {
             led_on(leds[i]);
-            playTone(C5 + (i * 100), 100);
+            tone_start(notes[i], 100);
             
-            for (uint16_t j = 0; j < 150; j++) {
+            for (uint16_t j = 0; j < 250; j++) {
                 display_update(1);
                 _delay_ms(1);
             }
@@ -254,9 +229,9 @@ void led_dance(void) {
         
         for (int8_t i = num_leds - 2; i >= 0; i--) {
             led_on(leds[i]);
-            playTone(C5 + (i * 100), 100);
+            tone_start(notes[i], 100);
             
-            for (uint16_t j = 0; j < 150; j++) {
+            for (uint16_t j = 0; j < 250; j++) {
                 display_update(1);
                 _delay_ms(1);
             }
@@ -271,9 +246,9 @@ void led_dance(void) {
             led_on(leds[j]);
         }
         
-        playTone(C6, 200);
+        tone_start(C6, 200);
         
-        for (uint16_t j = 0; j < 200; j++) {
+        for (uint16_t j = 0; j < 400; j++) {
             display_update(1);
             _delay_ms(1);
         }
@@ -296,21 +271,20 @@ void led_dance(void) {
 void show_morse_for_string(const char* str) {
     printf("Showing Morse for string: %s\r\n", str);
     
-    for (uint8_t i = 0; str[i] != '\0'; i++) {
-        char char_display[5] = "    ";
-        char_display[0] = str[i];
-        display_string(char_display);
-        
-        for (uint16_t j = 0; j < 500; j++) {
-            display_update(1);
-            _delay_ms(1);
-        }
-   
-        show_morse_for_character(str[i]);
-        
-        for (uint16_t j = 0; j < LETTER_SPACE; j++) {
-            display_update(1);
-            _delay_ms(1);
+    morse_send(str);
+
+    char shown = 0;
+
+    while (morse_busy()) {
+        char current = morse_current_char();
+
+        if (current != shown) {
+            char char_display[5] = "    ";
+            char_display[0] = current ? current : ' ';
+            display_string(char_display);
+            shown = current;
         }
+
+        display_update(1);
     }
 }
\ No newline at end of file
@@ -9,6 +9,10 @@
 #include "usart.h"
 #include "potentiometer.h"
 #include "sound.h"
+#include "random.h"
+#include "entropy.h"
+#include "arena.h"
+#include "storage.h"
 
 #define DEFAULT_START_AMOUNT 21
 #define DEFAULT_MAX_TAKE 3
@@ -50,6 +54,8 @@ typedef struct
     uint8_t remaining_after;
 } Move;
 
+ARENA_CHECK(ARENA_BYTES(MAX_MOVES * sizeof(Move)));
+
 void init_game(GameState *game, uint8_t start_amount, uint8_t max_take);
 void display_game_state(GameState *game);
 void process_player_turn(GameState *game, Move *history, uint8_t *move_count);
@@ -67,6 +73,7 @@ void transmit_string(const char *str);
 void show_config_display(const char *label, uint8_t value);
 void play_victory_sound(uint8_t winner);
 void play_game_over_sequence(GameState *game);
+void record_score(uint8_t winner);
 
 int main(void)
 {
@@ -76,6 +83,10 @@ int main(void)
     usart_init();
     potentiometer_init();
     buzzer_init();
+    storage_init();
+
+    // Tones and LED effects run from timer interrupts
+    sei();
 
     uint16_t seed = 0;
     uint8_t start_amount = DEFAULT_START_AMOUNT;
@@ -99,6 +110,9 @@ int main(void)
 
         display_seed(seed);
 
+        // Keep sampling noise while waiting, the press moment adds timing jitter
+        entropy_collect(4);
+
         if (read_button(BUTTON_PLAY_PIN) == 0)
         {
             button_pressed = 1;
@@ -107,7 +121,8 @@ int main(void)
     }
 
     _delay_ms(BUTTON_DEBOUNCE_MS);
-    srand(seed);
+    entropy_add(seed);
+    random_global_init();
 
     transmit_string("Configuring game parameters...\r\n");
     if (!configure_game_parameters(&start_amount, &max_take))
@@ -119,7 +134,7 @@ int main(void)
 
     GameState game;
 
-    Move *history = (Move *)calloc(MAX_MOVES, sizeof(Move));
+    Move *history = (Move *)arena_alloc(MAX_MOVES * sizeof(Move));
     if (history == NULL)
     {
         transmit_string("Memory allocation failed!\r\n");
@@ -138,10 +153,11 @@ int main(void)
 
     play_game(&game, history, &move_count);
 
+    record_score(game.winner);
     play_game_over_sequence(&game);
     print_game_history(history, move_count, &game);
 
-    free(history);
+    arena_release(history);
 
     while (1)
     {
@@ -190,7 +206,7 @@ void init_game(GameState *game, uint8_t start_amount, uint8_t max_take)
     game->game_over = 0;
     game->winner = 0;
 
-    game->current_player = rand() % 2;
+    game->current_player = random_global_int_range(PLAYER, COMPUTER);
 
     display_game_state(game);
 }
@@ -339,7 +355,7 @@ void process_player_turn(GameState *game, Move *history, uint8_t *move_count)
 
                 record_move(history, move_count, PLAYER, game->take_amount, game->sticks_remaining);
 
-                playTone(C5, 100);
+                tone_start(C5, 100);
 
                 if (game->sticks_remaining == 0)
                 {
@@ -404,7 +420,7 @@ void process_computer_turn(GameState *game, Move *history, uint8_t *move_count)
 
             record_move(history, move_count, COMPUTER, game->take_amount, game->sticks_remaining);
 
-            playTone(G5, 100);
+            tone_start(G5, 100);
 
             if (game->sticks_remaining == 0)
             {
@@ -436,7 +452,7 @@ uint8_t calculate_computer_move(GameState *game)
 
     if (optimal_move == 0)
     {
-        uint8_t random_move = (rand() % game->max_take) + 1;
+        uint8_t random_move = random_global_int_range(1, game->max_take);
 
         if (random_move > game->sticks_remaining)
         {
@@ -504,17 +520,11 @@ void play_victory_sound(uint8_t winner)
 {
     if (winner == PLAYER)
     {
-        playTone(C5, 200);
-        playTone(E5, 200);
-        playTone(G5, 200);
-        playTone(C6, 400);
+        melody_play(MELODY_FANFARE);
     }
     else
     {
-        playTone(C6, 200);
-        playTone(G5, 200);
-        playTone(E5, 200);
-        playTone(C5, 400);
+        melody_play(MELODY_FALLING);
     }
 }
 
@@ -545,6 +555,32 @@ void play_game_over_sequence(GameState *game)
     display_winner(game->winner);
 }
 
+/**
+ * Count a win in the score kept in EEPROM
+ * Player wins in the low half, computer wins in the high half
+ * @param winner PLAYER or COMPUTER
+ */
+void record_score(uint8_t winner)
+{
+    uint32_t score = 0;
+    storage_get(STORAGE_KEY_NIM_SCORE, &score);
+
+    uint16_t player_wins = score & 0xFFFF;
+    uint16_t computer_wins = score >> 16;
+
+    if (winner == PLAYER)
+    {
+        player_wins++;
+    }
+    else
+    {
+        computer_wins++;
+    }
+
+    storage_set(STORAGE_KEY_NIM_SCORE, ((uint32_t)computer_wins << 16) | player_wins);
+    storage_flush();
+}
+
 /**
  * Main game loop
  */
@@ -592,6 +628,16 @@ void print_game_history(Move *history, uint8_t move_count, GameState *game)
             (game->winner == PLAYER) ? "Player" : "Computer");
     transmit_string(buffer);
 
+    uint32_t score = 0;
+    storage_get(STORAGE_KEY_NIM_SCORE, &score);
+    sprintf(buffer, "All games: Player %u, Computer %u\r\n",
+            (unsigned)(score & 0xFFFF), (unsigned)(score >> 16));
+    transmit_string(buffer);
+
+    sprintf(buffer, "Arena: peak %u of %u bytes\r\n",
+            (unsigned)arena_high_water(), (unsigned)ARENA_SIZE);
+    transmit_string(buffer);
+
     transmit_string("==================\r\n");
 }
 
@@ -8,6 +8,9 @@
 #include "buttons.h"
 #include "usart.h"
 #include "sound.h"
+#include "random.h"
+#include "entropy.h"
+#include "storage.h"
 
 #define MAX_LEVEL 10
 #define BLINK_SPEED 50
@@ -31,6 +34,7 @@ uint8_t readInput(uint8_t* puzzle, uint8_t level);
 void playWinSequence(void);
 void playLoseSequence(void);
 void waitForStart(void);
+void recordHighScore(uint8_t level);
 
 ISR(PCINT1_vect) {
     if (!(PINC & (1 << GAME_BUTTON_1)) ||
@@ -47,6 +51,7 @@ int main(void) {
     buttons_init();
     usart_init();
     buzzer_init();
+    storage_init();
     
     initGame();
     
@@ -85,21 +90,8 @@ int main(void) {
         uint8_t result = readInput(puzzle, currentLevel);
         
         if (result == 1) {
-            for (uint8_t i = 0; i < FEEDBACK_BLINKS; i++) {
-                led_on(GAME_LED_4);
-                
-                for (uint16_t j = 0; j < 50; j++) {
-                    display_update(1);
-                    _delay_ms(1);
-                }
-                
-                led_off(GAME_LED_4);
-                
-                for (uint16_t j = 0; j < 50; j++) {
-                    display_update(1);
-                    _delay_ms(1);
-                }
-            }
+            // On 50 ms, off 50 ms, while the next level is announced
+            led_effect_start(GAME_LED_4, 0x01, 2, 50, FEEDBACK_BLINKS);
             
             currentLevel++;
         
@@ -150,6 +142,8 @@ int main(void) {
         _delay_ms(1);
     }
 
+    recordHighScore(currentLevel - 1);
+
     display_string("    ");
     
     while (1) {
@@ -159,6 +153,35 @@ int main(void) {
     return 0;
 }
 
+/**
+ * Keep the highest completed level in EEPROM and show it
+ * @param level Levels completed in this game
+ */
+void recordHighScore(uint8_t level) {
+    uint32_t best = 0;
+    storage_get(STORAGE_KEY_SIMON_SCORE, &best);
+
+    char message[50];
+
+    if (level > best) {
+        best = level;
+        storage_set(STORAGE_KEY_SIMON_SCORE, best);
+        storage_flush();
+        transmit_string("New high score!\r\n");
+    }
+
+    sprintf(message, "High score: level %u\r\n", (unsigned)best);
+    transmit_string(message);
+
+    sprintf(message, "HI%02u", (unsigned)best);
+    display_string(message);
+
+    for (uint16_t i = 0; i < 1000; i++) {
+        display_update(1);
+        _delay_ms(1);
+    }
+}
+
 /**
  * Initialize the game components
  */
@@ -183,24 +206,19 @@ void waitForStart(void) {
  
     button_pushed = 0;
     
-    while (!button_pushed) {
-        led_on(GAME_LED_4);
-        
-        for (uint8_t i = 0; i < BLINK_SPEED / 10; i++) {
-            display_update(1);
-            _delay_ms(5); 
-            random_seed++;
-        }
-        
-        led_off(GAME_LED_4);
+    led_effect_start(GAME_LED_4, 0x01, 2, BLINK_SPEED / 2, 0);
 
-        for (uint8_t i = 0; i < BLINK_SPEED / 10; i++) {
-            display_update(1);
-            _delay_ms(5);  
-            random_seed++; 
-        }
+    while (!button_pushed) {
+        display_update(1);
+        _delay_ms(5);
+        random_seed++;
     }
-    srand(random_seed);
+
+    led_effect_cancel(GAME_LED_4);
+    // The tick count at the press mostly reflects human timing, mix it with ADC noise
+    entropy_add(random_seed);
+    entropy_add(random_seed >> 16);
+    random_global_init();
 }
 
 /**
@@ -210,7 +228,7 @@ void waitForStart(void) {
  */
 void generatePuzzle(uint8_t* puzzle, uint8_t length) {
     for (uint8_t i = 0; i < length; i++) {
-        puzzle[i] = rand() % 3;
+        puzzle[i] = random_global_int_range(0, 2);
     }
 }
 
@@ -345,10 +363,7 @@ uint8_t readInput(uint8_t* puzzle, uint8_t level) {
  * Play a win sequence animation with lights and sound
  */
 void playWinSequence(void) {
-    playTone(C5, 200);
-    playTone(E5, 200);
-    playTone(G5, 200);
-    playTone(C6, 400);
+    melody_play(MELODY_FANFARE);
     
     led_on(GAME_LED_1);
     led_on(GAME_LED_2);
@@ -393,8 +408,7 @@ void playWinSequence(void) {
  * Play a lose sequence animation with lights and sound
  */
 void playLoseSequence(void) {
-    playTone(C5, 300);
-    playTone(G5, 500);
+    melody_play(MELODY_FAILURE);
     
     led_on(GAME_LED_1);
     led_on(GAME_LED_2);